@@ -604,12 +604,32 @@ __LA_DECL int archive_read_next_header(struct archive *,
 __LA_DECL int archive_read_next_header2(struct archive *,
 		     struct archive_entry *);
 
+/*
+ * Fills up to _count of the caller's archive_entry objects with the
+ * next headers, skipping entry data.  *_filled is set to the number of
+ * entries populated, which may be non-zero even when the return value
+ * is ARCHIVE_EOF or an error.
+ */
+__LA_DECL int archive_read_next_headers(struct archive *,
+		     struct archive_entry **_entries, size_t _count,
+		     size_t *_filled);
+
 /*
  * Retrieve the byte offset in UNCOMPRESSED data where last-read
  * header started.
  */
 __LA_DECL la_int64_t		 archive_read_header_position(struct archive *);
 
+/*
+ * Reposition the reader at a header offset previously returned by
+ * archive_read_header_position(), so the next call to
+ * archive_read_next_header() returns that entry.  Requires a client
+ * seek callback and a format that supports it (currently tar).  The
+ * input must be uncompressed, gzip with the "gzip:checkpoint-interval"
+ * or "gzip:index" option, or seekable zstd with "zstd:seekable".
+ */
+__LA_DECL int archive_read_seek_header(struct archive *, la_int64_t);
+
 /*
  * Returns 1 if the archive contains at least one encrypted entry.
  * If the archive format not support encryption at all
@@ -640,7 +660,11 @@ __LA_DECL int		 archive_read_format_capabilities(struct archive *);
 __LA_DECL la_ssize_t		 archive_read_data(struct archive *,
 				    void *, size_t);
 
-/* Seek within the body of an entry.  Similar to lseek(2). */
+/*
+ * Seek within the body of an entry.  Similar to lseek(2).
+ * Supported for tar, cpio, stored RAR and stored Zip entries;
+ * seeking backward requires a seekable input.
+ */
 __LA_DECL la_int64_t archive_seek_data(struct archive *, la_int64_t, int);
 
 /*
@@ -0,0 +1,75 @@
+/*-
+ * Copyright (c) 2026 libarchive contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef ARCHIVE_BCJ_PRIVATE_H_INCLUDED
+#define ARCHIVE_BCJ_PRIVATE_H_INCLUDED
+
+/* Note:  This is a purely internal header! */
+/* Do not use this outside of libarchive internal code! */
+
+#ifndef __LIBARCHIVE_BUILD
+#error This header is only to be used internally to libarchive.
+#endif
+
+#ifdef HAVE_STDINT_H
+#include <stdint.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+/*
+ * Return a pointer to the first x86 CALL (0xE8) byte in [p, end), or
+ * also JMP (0xE9) when 'e9also' is set; return 'end' if there is none.
+ *
+ * The branch converters used by the 7-Zip and RAR readers spend most of
+ * their time looking for these opcodes, so eight bytes are tested at a
+ * time: clearing the low bit of each byte folds E9 onto E8 and the XOR
+ * turns matches into zero bytes, which the usual "has a zero byte" test
+ * detects.  Words that contain a candidate are rescanned byte by byte.
+ */
+static inline uint8_t *
+__archive_bcj_find_e8(uint8_t *p, const uint8_t *end, int e9also)
+{
+	const uint64_t ones = UINT64_C(0x0101010101010101);
+	const uint64_t fold = e9also ? ~ones : ~UINT64_C(0);
+	const uint64_t e8 = ones * 0xE8;
+	const uint8_t mask = (uint8_t)fold;
+	uint64_t w;
+
+	for (; end - p >= 8; p += 8) {
+		memcpy(&w, p, sizeof(w));
+		w = (w & fold) ^ e8;
+		if (((w - ones) & ~w & (ones << 7)) != 0)
+			break;
+	}
+	for (; p < end; p++)
+		if ((*p & mask) == 0xE8)
+			break;
+	return (p);
+}
+
+#endif
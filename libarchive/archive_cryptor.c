@@ -387,22 +387,40 @@ aes_ctr_init(archive_crypto_ctx *ctx, const uint8_t *key, size_t key_len)
 	ctx->key_len = key_len;
 	memcpy(ctx->key, key, key_len);
 	memset(ctx->nonce, 0, sizeof(ctx->nonce));
-	ctx->encr_pos = AES_BLOCK_SIZE;
+	ctx->encr_pos = sizeof(ctx->encr_buf);
+
+	/* Expand the key once here rather than for every counter block;
+	 * an ECB context without padding can be updated indefinitely. */
+	if (EVP_EncryptInit_ex(ctx->ctx, ctx->type, NULL, ctx->key, NULL) == 0) {
+		EVP_CIPHER_CTX_free(ctx->ctx);
+		ctx->ctx = NULL;
+		return -1;
+	}
+	EVP_CIPHER_CTX_set_padding(ctx->ctx, 0);
 	return 0;
 }
 
+static void aes_ctr_increase_counter(archive_crypto_ctx *ctx);
+
 static int
 aes_ctr_encrypt_counter(archive_crypto_ctx *ctx)
 {
+	uint8_t ctr[sizeof(ctx->encr_buf)];
 	int outl = 0;
 	int r;
+	size_t i;
 
-	r = EVP_EncryptInit_ex(ctx->ctx, ctx->type, NULL, ctx->key, NULL);
-	if (r == 0)
-		return -1;
-	r = EVP_EncryptUpdate(ctx->ctx, ctx->encr_buf, &outl, ctx->nonce,
-	    AES_BLOCK_SIZE);
-	if (r == 0 || outl != AES_BLOCK_SIZE)
+	/* Encrypt a whole run of consecutive counter values in one call so
+	 * that the cipher can pipeline the blocks; the nonce is left at the
+	 * last counter value used. */
+	for (i = 0; i < sizeof(ctr); i += AES_BLOCK_SIZE) {
+		if (i > 0)
+			aes_ctr_increase_counter(ctx);
+		memcpy(ctr + i, ctx->nonce, AES_BLOCK_SIZE);
+	}
+	r = EVP_EncryptUpdate(ctx->ctx, ctx->encr_buf, &outl, ctr,
+	    (int)sizeof(ctr));
+	if (r == 0 || outl != (int)sizeof(ctr))
 		return -1;
 	return 0;
 }
@@ -477,19 +495,20 @@ aes_ctr_update(archive_crypto_ctx *ctx, const uint8_t * const in,
     size_t in_len, uint8_t * const out, size_t *out_len)
 {
 	uint8_t *const ebuf = ctx->encr_buf;
+	const size_t ebuf_size = sizeof(ctx->encr_buf);
 	size_t pos = ctx->encr_pos;
 	size_t max = (in_len < *out_len)? in_len: *out_len;
 	size_t i;
 
 	for (i = 0; i < max; ) {
-		if (pos == AES_BLOCK_SIZE) {
+		if (pos == ebuf_size) {
 			aes_ctr_increase_counter(ctx);
 			if (aes_ctr_encrypt_counter(ctx) != 0)
 				return -1;
-			while (max -i >= AES_BLOCK_SIZE) {
-				for (pos = 0; pos < AES_BLOCK_SIZE; pos++)
+			while (max -i >= ebuf_size) {
+				for (pos = 0; pos < ebuf_size; pos++)
 					out[i+pos] = in[i+pos] ^ ebuf[pos];
-				i += AES_BLOCK_SIZE;
+				i += ebuf_size;
 				aes_ctr_increase_counter(ctx);
 				if (aes_ctr_encrypt_counter(ctx) != 0)
 					return -1;
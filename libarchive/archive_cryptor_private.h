@@ -132,7 +132,7 @@ typedef struct {
 	uint8_t		key[AES_MAX_KEY_SIZE];
 	unsigned	key_len;
 	uint8_t		nonce[AES_BLOCK_SIZE];
-	uint8_t		encr_buf[AES_BLOCK_SIZE];
+	uint8_t		encr_buf[AES_BLOCK_SIZE * 16]; /* Keystream for 16 counters. */
 	unsigned	encr_pos;
 } archive_crypto_ctx;
 
@@ -153,21 +153,45 @@ static size_t wcslen(const wchar_t *s)
 struct archive_entry *
 archive_entry_clear(struct archive_entry *entry)
 {
+	struct archive_mstring fflags_text, gname, linkname;
+	struct archive_mstring pathname, sourcepath, uname;
+	void *st;
+
 	if (entry == NULL)
 		return (NULL);
-	archive_mstring_clean(&entry->ae_fflags_text);
-	archive_mstring_clean(&entry->ae_gname);
-	archive_mstring_clean(&entry->ae_linkname);
-	archive_mstring_clean(&entry->ae_pathname);
-	archive_mstring_clean(&entry->ae_sourcepath);
-	archive_mstring_clean(&entry->ae_uname);
 	archive_entry_copy_mac_metadata(entry, NULL, 0);
 	archive_acl_clear(&entry->acl);
 	archive_entry_xattr_clear(entry);
 	archive_entry_sparse_clear(entry);
-	free(entry->stat);
-	entry->ae_symlink_type = AE_SYMLINK_TYPE_UNDEFINED;
+
+	/*
+	 * Readers recycle a single entry for every header, so hang on
+	 * to the string and stat buffers instead of freeing them here
+	 * and allocating them all over again for the next entry.
+	 * archive_entry_free() releases them.
+	 */
+	fflags_text = entry->ae_fflags_text;
+	gname = entry->ae_gname;
+	linkname = entry->ae_linkname;
+	pathname = entry->ae_pathname;
+	sourcepath = entry->ae_sourcepath;
+	uname = entry->ae_uname;
+	st = entry->stat;
 	memset(entry, 0, sizeof(*entry));
+	entry->ae_symlink_type = AE_SYMLINK_TYPE_UNDEFINED;
+	entry->ae_fflags_text = fflags_text;
+	entry->ae_gname = gname;
+	entry->ae_linkname = linkname;
+	entry->ae_pathname = pathname;
+	entry->ae_sourcepath = sourcepath;
+	entry->ae_uname = uname;
+	entry->stat = st;
+	archive_mstring_empty(&entry->ae_fflags_text);
+	archive_mstring_empty(&entry->ae_gname);
+	archive_mstring_empty(&entry->ae_linkname);
+	archive_mstring_empty(&entry->ae_pathname);
+	archive_mstring_empty(&entry->ae_sourcepath);
+	archive_mstring_empty(&entry->ae_uname);
 	return entry;
 }
 
@@ -248,7 +272,16 @@ archive_entry_clone(struct archive_entry *entry)
 void
 archive_entry_free(struct archive_entry *entry)
 {
+	if (entry == NULL)
+		return;
 	archive_entry_clear(entry);
+	archive_mstring_clean(&entry->ae_fflags_text);
+	archive_mstring_clean(&entry->ae_gname);
+	archive_mstring_clean(&entry->ae_linkname);
+	archive_mstring_clean(&entry->ae_pathname);
+	archive_mstring_clean(&entry->ae_sourcepath);
+	archive_mstring_clean(&entry->ae_uname);
+	free(entry->stat);
 	free(entry);
 }
 
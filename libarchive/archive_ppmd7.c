@@ -772,14 +772,31 @@ static Bool PpmdRAR_RangeDec_Init(CPpmd7z_RangeDec *p)
   return True;
 }
 
-static UInt32 Range_GetThreshold(void *pp, UInt32 total)
+/*
+ * The range decoder primitives are static inline and take the RAR flag
+ * as a constant, so that Ppmd7_DecodeSymbol() below gets its own copy
+ * of the model walk for each of the two range coder variants instead
+ * of calling through the IPpmd7_RangeDec vtable several times per
+ * decoded byte.
+ */
+
+static inline UInt32 Range_GetThreshold_Inline(CPpmd7z_RangeDec *p, UInt32 total)
 {
-  CPpmd7z_RangeDec *p = (CPpmd7z_RangeDec *)pp;
   return (p->Code - p->Low) / (p->Range /= total);
 }
 
-static void Range_Normalize(CPpmd7z_RangeDec *p)
+static inline void Range_Normalize(CPpmd7z_RangeDec *p, int rar)
 {
+  if (!rar)
+  {
+    /* 7z never moves Low, so only the range width matters. */
+    while (p->Range < kTopValue)
+    {
+      p->Code = (p->Code << 8) | p->Stream->Read((void *)p->Stream);
+      p->Range <<= 8;
+    }
+    return;
+  }
   while (1)
   {
     if((p->Low ^ (p->Low + p->Range)) >= kTopValue)
@@ -795,57 +812,75 @@ static void Range_Normalize(CPpmd7z_RangeDec *p)
   }
 }
 
-static void Range_Decode_7z(void *pp, UInt32 start, UInt32 size)
-{
-  CPpmd7z_RangeDec *p = (CPpmd7z_RangeDec *)pp;
-  p->Code -= start * p->Range;
-  p->Range *= size;
-  Range_Normalize(p);
-}
-
-static void Range_Decode_RAR(void *pp, UInt32 start, UInt32 size)
+static inline void Range_Decode_Inline(CPpmd7z_RangeDec *p, UInt32 start, UInt32 size, int rar)
 {
-  CPpmd7z_RangeDec *p = (CPpmd7z_RangeDec *)pp;
-  p->Low += start * p->Range;
+  if (rar)
+    p->Low += start * p->Range;
+  else
+    p->Code -= start * p->Range;
   p->Range *= size;
-  Range_Normalize(p);
+  Range_Normalize(p, rar);
 }
 
-static UInt32 Range_DecodeBit_7z(void *pp, UInt32 size0)
+static inline UInt32 Range_DecodeBit_Inline(CPpmd7z_RangeDec *p, UInt32 size0, int rar)
 {
-  CPpmd7z_RangeDec *p = (CPpmd7z_RangeDec *)pp;
-  UInt32 newBound = (p->Range >> 14) * size0;
-  UInt32 symbol;
-  if (p->Code < newBound)
+  UInt32 bit;
+  if (rar)
   {
-    symbol = 0;
-    p->Range = newBound;
+    UInt32 value = Range_GetThreshold_Inline(p, PPMD_BIN_SCALE);
+    if(value < size0)
+    {
+      bit = 0;
+      Range_Decode_Inline(p, 0, size0, 1);
+    }
+    else
+    {
+      bit = 1;
+      Range_Decode_Inline(p, size0, PPMD_BIN_SCALE - size0, 1);
+    }
   }
   else
   {
-    symbol = 1;
-    p->Code -= newBound;
-    p->Range -= newBound;
+    UInt32 newBound = (p->Range >> 14) * size0;
+    if (p->Code < newBound)
+    {
+      bit = 0;
+      p->Range = newBound;
+    }
+    else
+    {
+      bit = 1;
+      p->Code -= newBound;
+      p->Range -= newBound;
+    }
+    Range_Normalize(p, 0);
   }
-  Range_Normalize(p);
-  return symbol;
+  return bit;
+}
+
+static UInt32 Range_GetThreshold(void *pp, UInt32 total)
+{
+  return Range_GetThreshold_Inline((CPpmd7z_RangeDec *)pp, total);
+}
+
+static void Range_Decode_7z(void *pp, UInt32 start, UInt32 size)
+{
+  Range_Decode_Inline((CPpmd7z_RangeDec *)pp, start, size, 0);
+}
+
+static void Range_Decode_RAR(void *pp, UInt32 start, UInt32 size)
+{
+  Range_Decode_Inline((CPpmd7z_RangeDec *)pp, start, size, 1);
+}
+
+static UInt32 Range_DecodeBit_7z(void *pp, UInt32 size0)
+{
+  return Range_DecodeBit_Inline((CPpmd7z_RangeDec *)pp, size0, 0);
 }
 
 static UInt32 Range_DecodeBit_RAR(void *pp, UInt32 size0)
 {
-  CPpmd7z_RangeDec *p = (CPpmd7z_RangeDec *)pp;
-  UInt32 bit, value = p->p.GetThreshold(p, PPMD_BIN_SCALE);
-  if(value < size0)
-  {
-    bit = 0;
-    p->p.Decode(p, 0, size0);
-  }
-  else
-  {
-    bit = 1;
-    p->p.Decode(p, size0, PPMD_BIN_SCALE - size0);
-  }
-  return bit;
+  return Range_DecodeBit_Inline((CPpmd7z_RangeDec *)pp, size0, 1);
 }
 
 static void Ppmd7z_RangeDec_CreateVTable(CPpmd7z_RangeDec *p)
@@ -864,7 +899,7 @@ static void PpmdRAR_RangeDec_CreateVTable(CPpmd7z_RangeDec *p)
 
 #define MASK(sym) ((signed char *)charMask)[sym]
 
-static int Ppmd7_DecodeSymbol(CPpmd7 *p, IPpmd7_RangeDec *rc)
+static inline int Ppmd7_DecodeSymbol_Inline(CPpmd7 *p, CPpmd7z_RangeDec *rc, int rar)
 {
   size_t charMask[256 / sizeof(size_t)];
   if (p->MinContext->NumStats != 1)
@@ -872,10 +907,10 @@ static int Ppmd7_DecodeSymbol(CPpmd7 *p, IPpmd7_RangeDec *rc)
     CPpmd_State *s = Ppmd7_GetStats(p, p->MinContext);
     unsigned i;
     UInt32 count, hiCnt;
-    if ((count = rc->GetThreshold(rc, p->MinContext->SummFreq)) < (hiCnt = s->Freq))
+    if ((count = Range_GetThreshold_Inline(rc, p->MinContext->SummFreq)) < (hiCnt = s->Freq))
     {
       Byte symbol;
-      rc->Decode(rc, 0, s->Freq);
+      Range_Decode_Inline(rc, 0, s->Freq, rar);
       p->FoundState = s;
       symbol = s->Symbol;
       Ppmd7_Update1_0(p);
@@ -888,7 +923,7 @@ static int Ppmd7_DecodeSymbol(CPpmd7 *p, IPpmd7_RangeDec *rc)
       if ((hiCnt += (++s)->Freq) > count)
       {
         Byte symbol;
-        rc->Decode(rc, hiCnt - s->Freq, s->Freq);
+        Range_Decode_Inline(rc, hiCnt - s->Freq, s->Freq, rar);
         p->FoundState = s;
         symbol = s->Symbol;
         Ppmd7_Update1(p);
@@ -899,7 +934,7 @@ static int Ppmd7_DecodeSymbol(CPpmd7 *p, IPpmd7_RangeDec *rc)
     if (count >= p->MinContext->SummFreq)
       return -2;
     p->HiBitsFlag = p->HB2Flag[p->FoundState->Symbol];
-    rc->Decode(rc, hiCnt, p->MinContext->SummFreq - hiCnt);
+    Range_Decode_Inline(rc, hiCnt, p->MinContext->SummFreq - hiCnt, rar);
     PPMD_SetAllBitsIn256Bytes(charMask);
     MASK(s->Symbol) = 0;
     i = p->MinContext->NumStats - 1;
@@ -908,7 +943,7 @@ static int Ppmd7_DecodeSymbol(CPpmd7 *p, IPpmd7_RangeDec *rc)
   else
   {
     UInt16 *prob = Ppmd7_GetBinSumm(p);
-    if (rc->DecodeBit(rc, *prob) == 0)
+    if (Range_DecodeBit_Inline(rc, *prob, rar) == 0)
     {
       Byte symbol;
       *prob = (UInt16)PPMD_UPDATE_PROB_0(*prob);
@@ -951,7 +986,7 @@ static int Ppmd7_DecodeSymbol(CPpmd7 *p, IPpmd7_RangeDec *rc)
 
     see = Ppmd7_MakeEscFreq(p, numMasked, &freqSum);
     freqSum += hiCnt;
-    count = rc->GetThreshold(rc, freqSum);
+    count = Range_GetThreshold_Inline(rc, freqSum);
 
     if (count < hiCnt)
     {
@@ -959,7 +994,7 @@ static int Ppmd7_DecodeSymbol(CPpmd7 *p, IPpmd7_RangeDec *rc)
       CPpmd_State **pps = ps;
       for (hiCnt = 0; (hiCnt += (*pps)->Freq) <= count; pps++);
       s = *pps;
-      rc->Decode(rc, hiCnt - s->Freq, s->Freq);
+      Range_Decode_Inline(rc, hiCnt - s->Freq, s->Freq, rar);
       Ppmd_See_Update(see);
       p->FoundState = s;
       symbol = s->Symbol;
@@ -968,12 +1003,20 @@ static int Ppmd7_DecodeSymbol(CPpmd7 *p, IPpmd7_RangeDec *rc)
     }
     if (count >= freqSum)
       return -2;
-    rc->Decode(rc, hiCnt, freqSum - hiCnt);
+    Range_Decode_Inline(rc, hiCnt, freqSum - hiCnt, rar);
     see->Summ = (UInt16)(see->Summ + freqSum);
     do { MASK(ps[--i]->Symbol) = 0; } while (i != 0);
   }
 }
 
+static int Ppmd7_DecodeSymbol(CPpmd7 *p, IPpmd7_RangeDec *rc)
+{
+  /* Both vtables are set up on a CPpmd7z_RangeDec. */
+  if (rc->Decode == Range_Decode_RAR)
+    return Ppmd7_DecodeSymbol_Inline(p, (CPpmd7z_RangeDec *)rc, 1);
+  return Ppmd7_DecodeSymbol_Inline(p, (CPpmd7z_RangeDec *)rc, 0);
+}
+
 /* ---------- Encode ---------- Ppmd7Enc.c */
 
 #define kTopValue (1 << 24)
@@ -828,6 +828,45 @@ archive_read_header_position(struct archive *_a)
 	return (a->header_position);
 }
 
+/*
+ * Reposition the reader so that the next call to
+ * archive_read_next_header() returns the entry whose header starts at
+ * the given offset, which must be a value previously obtained from
+ * archive_read_header_position().  This lets a client that has
+ * recorded those offsets jump straight to a member instead of reading
+ * past everything in front of it.
+ */
+int
+archive_read_seek_header(struct archive *_a, la_int64_t offset)
+{
+	struct archive_read *a = (struct archive_read *)_a;
+	int r;
+
+	archive_check_magic(_a, ARCHIVE_READ_MAGIC,
+	    ARCHIVE_STATE_HEADER | ARCHIVE_STATE_DATA |
+	    ARCHIVE_STATE_DATA_RECOVERY | ARCHIVE_STATE_EOF,
+	    "archive_read_seek_header");
+
+	if (a->format == NULL || a->format->seek_header == NULL) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Cannot seek to a header with this format");
+		return (ARCHIVE_FAILED);
+	}
+	if (offset < 0) {
+		archive_set_error(&a->archive, EINVAL,
+		    "Invalid header offset %jd", (intmax_t)offset);
+		return (ARCHIVE_FAILED);
+	}
+
+	archive_clear_error(&a->archive);
+	r = (a->format->seek_header)(a, offset);
+	if (r == ARCHIVE_OK)
+		a->archive.state = ARCHIVE_STATE_HEADER;
+	else if (r == ARCHIVE_FATAL)
+		a->archive.state = ARCHIVE_STATE_FATAL;
+	return (r);
+}
+
 /*
  * Returns 1 if the archive contains at least one encrypted entry.
  * If the archive format does not support encryption at all,
@@ -1038,6 +1077,16 @@ archive_seek_data(struct archive *_a, int64_t offset, int whence)
 		return (ARCHIVE_FAILED);
 	}
 
+	/*
+	 * archive_read_data() may hold part of a block the client has
+	 * not seen yet; make SEEK_CUR relative to what it has seen.
+	 */
+	if (whence == SEEK_CUR && (a->archive.read_data_remaining > 0 ||
+	    a->archive.read_data_offset > a->archive.read_data_output_offset)) {
+		offset += a->archive.read_data_output_offset;
+		whence = SEEK_SET;
+	}
+
 	r = (a->format->seek_data)(a, offset, whence);
 	if (r == ARCHIVE_FATAL)
 		a->archive.state = ARCHIVE_STATE_FATAL;
@@ -1279,7 +1328,8 @@ __archive_read_register_format(struct archive_read *a,
     int64_t (*seek_data)(struct archive_read *, int64_t, int),
     int (*cleanup)(struct archive_read *),
     int (*format_capabilities)(struct archive_read *),
-    int (*has_encrypted_entries)(struct archive_read *))
+    int (*has_encrypted_entries)(struct archive_read *),
+    int (*seek_header)(struct archive_read *, int64_t))
 {
 	int i, number_slots;
 
@@ -1304,6 +1354,7 @@ __archive_read_register_format(struct archive_read *a,
 			a->formats[i].name = name;
 			a->formats[i].format_capabilties = format_capabilities;
 			a->formats[i].has_encrypted_entries = has_encrypted_entries;
+			a->formats[i].seek_header = seek_header;
 			return (ARCHIVE_OK);
 		}
 	}
@@ -1707,6 +1758,24 @@ __archive_read_seek(struct archive_read *a, int64_t offset, int whence)
 	return __archive_read_filter_seek(a->filter, offset, whence);
 }
 
+/*
+ * Move to an absolute position in the (decompressed) stream.
+ * Moving forward only needs to skip, so it works with any input;
+ * moving backward requires seeking and returns ARCHIVE_FAILED if
+ * that isn't supported.
+ */
+int64_t
+__archive_read_reposition(struct archive_read *a, int64_t offset)
+{
+	int64_t request = offset - a->filter->position;
+
+	if (request < 0)
+		return __archive_read_seek(a, offset, SEEK_SET);
+	if (__archive_read_consume(a, request) != request)
+		return (ARCHIVE_FATAL);
+	return (offset);
+}
+
 int64_t
 __archive_read_filter_seek(struct archive_read_filter *f, int64_t offset,
     int whence)
@@ -1720,6 +1789,24 @@ __archive_read_filter_seek(struct archive_read_filter *f, int64_t offset,
 	if (f->can_seek == 0)
 		return (ARCHIVE_FAILED);
 
+	if (f->upstream != NULL) {
+		/* A decompression filter that can reposition itself. */
+		if (f->vtable->seek == NULL)
+			return (ARCHIVE_FAILED);
+		if (whence == SEEK_CUR) {
+			offset += f->position;
+			whence = SEEK_SET;
+		}
+		r = (f->vtable->seek)(f, offset, whence);
+		if (r >= 0) {
+			f->avail = f->client_avail = 0;
+			f->next = f->buffer;
+			f->position = r;
+			f->end_of_file = 0;
+		}
+		return r;
+	}
+
 	client = &(f->archive->client);
 	switch (whence) {
 	case SEEK_CUR:
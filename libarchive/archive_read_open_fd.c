@@ -50,9 +50,17 @@
 #include "archive.h"
 #include "archive_platform_stat.h"
 
+/*
+ * After skipping the body of an entry, the next thing needed is
+ * usually just a 512-byte header, so start with a read of this size
+ * and grow it back toward the block size.
+ */
+#define	READ_AFTER_SKIP	512
+
 struct read_fd_data {
 	int	 fd;
 	size_t	 block_size;
+	size_t	 read_size;  /* Short read size after a skip, or zero. */
 	int64_t	 size;
 	char	 use_lseek;
 	void	*buffer;
@@ -122,10 +130,19 @@ file_read(struct archive *a, void *client_data, const void **buff)
 {
 	struct read_fd_data *mine = (struct read_fd_data *)client_data;
 	ssize_t bytes_read;
+	size_t size;
+
+	size = mine->block_size;
+	if (mine->read_size != 0) {
+		size = mine->read_size;
+		mine->read_size *= 4;
+		if (mine->read_size >= mine->block_size)
+			mine->read_size = 0;
+	}
 
 	*buff = mine->buffer;
 	for (;;) {
-		bytes_read = read(mine->fd, mine->buffer, mine->block_size);
+		bytes_read = read(mine->fd, mine->buffer, size);
 		if (bytes_read < 0) {
 			if (errno == EINTR)
 				continue;
@@ -155,9 +172,8 @@ file_skip(struct archive *a, void *client_data, int64_t request)
 			skip = (off_t)max_skip;
 	}
 
-	/* Reduce 'skip' to the next smallest multiple of block_size */
-	skip = (la_seek_t)(((int64_t)skip / mine->block_size) * mine->block_size);
-
+	/* Only regular files use lseek(), so there is no need to
+	 * round the request to a multiple of block_size. */
 	if (skip == 0)
 		return (0);
 
@@ -166,8 +182,11 @@ file_skip(struct archive *a, void *client_data, int64_t request)
 		    skip > mine->size - old_offset) {
 			/* Do not seek past end of file. */
 			errno = ESPIPE;
-		} else if ((new_offset = lseek(mine->fd, skip, SEEK_CUR)) >= 0)
+		} else if ((new_offset = lseek(mine->fd, skip, SEEK_CUR)) >= 0) {
+			if (mine->block_size > READ_AFTER_SKIP)
+				mine->read_size = READ_AFTER_SKIP;
 			return (new_offset - old_offset);
+		}
 	}
 
 	/* If seek failed once, it will probably fail again. */
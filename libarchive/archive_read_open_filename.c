@@ -73,9 +73,24 @@
 #define O_CLOEXEC	0
 #endif
 
+/*
+ * After skipping the body of an entry, the next thing needed is
+ * usually just a 512-byte header, so regular files start with a read
+ * of this size and grow it back toward the block size.
+ */
+#define	READ_AFTER_SKIP	512
+
+/*
+ * When one volume of a multivolume set is opened, this much of the
+ * head of the next volume is handed to the kernel's readahead.
+ */
+#define	PREFETCH_NEXT_SIZE	(1024 * 1024)
+
 struct read_file_data {
+	struct read_file_data *next; /* Next volume, or NULL. */
 	int	 fd;
 	size_t	 block_size;
+	size_t	 read_size;  /* Short read size after a skip, or zero. */
 	void	*buffer;
 	mode_t	 st_mode;  /* Mode bits for opened file. */
 	int64_t	 size;
@@ -91,6 +106,7 @@ static int	file_open(struct archive *, void *);
 static int	file_close(struct archive *, void *);
 static int file_close2(struct archive *, void *);
 static int file_switch(struct archive *, void *, void *);
+static void	file_prefetch(struct read_file_data *);
 static ssize_t	file_read(struct archive *, void *, const void **buff);
 static int64_t	file_seek(struct archive *, void *, int64_t request, int);
 static int64_t	file_skip(struct archive *, void *, int64_t request);
@@ -117,7 +133,7 @@ int
 archive_read_open_filenames(struct archive *a, const char **filenames,
     size_t block_size)
 {
-	struct read_file_data *mine;
+	struct read_file_data *mine, *prev = NULL;
 	const char *filename = NULL;
 	if (filenames)
 		filename = *(filenames++);
@@ -145,6 +161,9 @@ archive_read_open_filenames(struct archive *a, const char **filenames,
 			free(mine);
 			return (ARCHIVE_FATAL);
 		}
+		if (prev != NULL)
+			prev->next = mine;
+		prev = mine;
 		if (filenames == NULL)
 			break;
 		filename = *(filenames++);
@@ -173,7 +192,7 @@ int
 archive_read_open_filenames_w(struct archive *a, const wchar_t **wfilenames,
     size_t block_size)
 {
-	struct read_file_data *mine;
+	struct read_file_data *mine, *prev = NULL;
 	const wchar_t *wfilename = NULL;
 	if (wfilenames)
 		wfilename = *(wfilenames++);
@@ -227,6 +246,9 @@ archive_read_open_filenames_w(struct archive *a, const wchar_t **wfilenames,
 			free(mine);
 			return (ARCHIVE_FATAL);
 		}
+		if (prev != NULL)
+			prev->next = mine;
+		prev = mine;
 		if (wfilenames == NULL)
 			break;
 		wfilename = *(wfilenames++);
@@ -415,6 +437,10 @@ file_open(struct archive *a, void *client_data)
 		mine->size = st.st_size;
 	}
 
+	/* Let the next volume load while this one is being read. */
+	if (S_ISREG(st.st_mode))
+		file_prefetch(mine->next);
+
 	return (ARCHIVE_OK);
 fail:
 	/*
@@ -431,6 +457,7 @@ file_read(struct archive *a, void *client_data, const void **buff)
 {
 	struct read_file_data *mine = (struct read_file_data *)client_data;
 	ssize_t bytes_read;
+	size_t size;
 
 	/* TODO: If a recent lseek() operation has left us
 	 * mis-aligned, read and return a short block to try to get
@@ -445,9 +472,17 @@ file_read(struct archive *a, void *client_data, const void **buff)
 	 * whatever we get here instead of waiting for a full block
 	 * worth of data. */
 
+	size = mine->block_size;
+	if (mine->read_size != 0) {
+		size = mine->read_size;
+		mine->read_size *= 4;
+		if (mine->read_size >= mine->block_size)
+			mine->read_size = 0;
+	}
+
 	*buff = mine->buffer;
 	for (;;) {
-		bytes_read = read(mine->fd, mine->buffer, mine->block_size);
+		bytes_read = read(mine->fd, mine->buffer, size);
 		if (bytes_read < 0) {
 			if (errno == EINTR)
 				continue;
@@ -513,8 +548,14 @@ file_skip_lseek(struct archive *a, void *client_data, int64_t request)
 		    skip > mine->size - old_offset) {
 			/* Do not seek past end of file. */
 			errno = ESPIPE;
-		} else if ((new_offset = lseek(mine->fd, skip, SEEK_CUR)) >= 0)
+		} else if ((new_offset = lseek(mine->fd, skip, SEEK_CUR)) >= 0) {
+			/* Raw disk devices may need aligned, full-size
+			 * reads; only shorten reads from regular files. */
+			if (S_ISREG(mine->st_mode)
+			    && mine->block_size > READ_AFTER_SKIP)
+				mine->read_size = READ_AFTER_SKIP;
 			return (new_offset - old_offset);
+		}
 	}
 
 	/* If lseek() fails, don't bother trying again. */
@@ -650,3 +691,32 @@ file_switch(struct archive *a, void *client_data1, void *client_data2)
 	file_close2(a, client_data1);
 	return file_open(a, client_data2);
 }
+
+/*
+ * Start reading the head of a volume in the background, so that the
+ * switch to it does not stall on slow or networked storage.  This is
+ * only a hint: it is skipped for anything but a regular file, since
+ * opening a FIFO or a tape device is not free of side effects, and
+ * any failure is ignored here and reported by file_open() later.
+ */
+static void
+file_prefetch(struct read_file_data *mine)
+{
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_WILLNEED)
+	struct stat st;
+	int fd;
+
+	if (mine == NULL || mine->filename_type != FNT_MBS)
+		return;
+	if (stat(mine->filename.m, &st) != 0 || !S_ISREG(st.st_mode))
+		return;
+	fd = open(mine->filename.m, O_RDONLY | O_BINARY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	__archive_ensure_cloexec_flag(fd);
+	(void)posix_fadvise(fd, 0, PREFETCH_NEXT_SIZE, POSIX_FADV_WILLNEED);
+	close(fd);
+#else
+	(void)mine; /* UNUSED */
+#endif
+}
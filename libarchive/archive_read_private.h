@@ -48,6 +48,11 @@ struct archive_read_filter_bidder_vtable {
 	int (*init)(struct archive_read_filter *);
 	/* Release the bidder's configuration data. */
 	void (*free)(struct archive_read_filter_bidder *);
+	/* Name matched against the module part of filter options. */
+	const char *name;
+	/* Set an option; filters created afterwards use it. */
+	int (*options)(struct archive_read_filter_bidder *, struct archive *,
+	    const char *key, const char *value);
 };
 
 /*
@@ -78,6 +83,8 @@ struct archive_read_filter_vtable {
 	int (*close)(struct archive_read_filter *);
 	/* Read any header metadata if available. */
 	int (*read_header)(struct archive_read_filter *, struct archive_entry *);
+	/* Reposition the output; only used if the filter sets can_seek. */
+	int64_t (*seek)(struct archive_read_filter *, int64_t, int);
 };
 
 /*
@@ -212,6 +219,7 @@ struct archive_read {
 		int	(*cleanup)(struct archive_read *);
 		int	(*format_capabilties)(struct archive_read *);
 		int	(*has_encrypted_entries)(struct archive_read *);
+		int	(*seek_header)(struct archive_read *, int64_t);
 	}	formats[16];
 	struct archive_format_descriptor	*format; /* Active format. */
 
@@ -244,7 +252,8 @@ int	__archive_read_register_format(struct archive_read *a,
 		int64_t (*seek_data)(struct archive_read *, int64_t, int),
 		int (*cleanup)(struct archive_read *),
 		int (*format_capabilities)(struct archive_read *),
-		int (*has_encrypted_entries)(struct archive_read *));
+		int (*has_encrypted_entries)(struct archive_read *),
+		int (*seek_header)(struct archive_read *, int64_t));
 
 int __archive_read_register_bidder(struct archive_read *a,
 		void *bidder_data,
@@ -255,6 +264,7 @@ const void *__archive_read_filter_ahead(struct archive_read_filter *,
     size_t, ssize_t *);
 int64_t	__archive_read_seek(struct archive_read*, int64_t, int);
 int64_t	__archive_read_filter_seek(struct archive_read_filter *, int64_t, int);
+int64_t	__archive_read_reposition(struct archive_read *, int64_t);
 int64_t	__archive_read_consume(struct archive_read *, int64_t);
 int64_t	__archive_read_filter_consume(struct archive_read_filter *, int64_t);
 int __archive_read_header(struct archive_read *, struct archive_entry *);
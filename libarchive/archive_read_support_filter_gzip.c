@@ -28,6 +28,9 @@
 #ifdef HAVE_ERRNO_H
 #include <errno.h>
 #endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
 #ifdef HAVE_STDLIB_H
 #include <stdlib.h>
 #endif
@@ -50,9 +53,45 @@
 #include "archive_private.h"
 #include "archive_read_private.h"
 
+#ifndef O_BINARY
+#define	O_BINARY 0
+#endif
+#ifndef O_CLOEXEC
+#define	O_CLOEXEC 0
+#endif
+
 #ifdef HAVE_ZLIB_H
+/*
+ * Random access support.  While decompressing, the filter can record
+ * a checkpoint at a deflate block boundary every so often: where the
+ * block starts in the compressed and the decompressed streams, plus
+ * the 32k of output that precedes it.  That is all inflate needs to
+ * resume there, so a seek only has to decompress from the nearest
+ * checkpoint at or before the target.
+ */
+#define	GZIP_WINDOW_SIZE	32768
+#define	GZIP_INDEX_MAGIC	"LAGZIDX2"
+#define	GZIP_DEFAULT_CHECKPOINT_INTERVAL	(16 * 1024 * 1024)
+
+struct gzip_checkpoint {
+	int64_t		 out;	/* Offset in decompressed data. */
+	int64_t		 in;	/* Offset of next compressed byte. */
+	int		 bits;	/* Unused bits of the byte before 'in'. */
+	unsigned	 window_size;
+	unsigned char	*window;
+};
+
+/* Options set before the filter exists. */
+struct gzip_bidder_options {
+	int64_t		 checkpoint_interval;
+	char		*index_file;
+};
+
 struct gzip {
 	z_stream	 stream;
+	/* The inflate state is set up once and reset for each member,
+	 * which matters for the many small members of BGZF files. */
+	char		 stream_valid;
 	char		 in_stream;
 	unsigned char	*out_block;
 	size_t		 out_block_size;
@@ -60,11 +99,38 @@ struct gzip {
 	uint32_t	 mtime;
 	char		*name;
 	char		 eof; /* True = found end of compressed data. */
+
+	/* Decompressed bytes produced so far. */
+	int64_t		 out_total;
+	/* Size of the block most recently returned from out_block. */
+	size_t		 out_block_used;
+	/* Part of out_block still to be returned after a seek. */
+	const unsigned char *pending_next;
+	size_t		 pending_size;
+
+	/* Compressed offset of the first gzip header. */
+	int64_t		 start_in;
+	int64_t		 checkpoint_interval;
+	struct gzip_checkpoint *checkpoints;
+	size_t		 checkpoints_used;
+	size_t		 checkpoints_size;
+	size_t		 checkpoints_saved;
+	char		*index_file;
+	/* Identifies the compressed file an index belongs to: its size,
+	 * the start of the first gzip header (with the modification
+	 * time) and the CRC32/ISIZE trailer of the last member.  The
+	 * size is -1 if it could not be determined. */
+	int64_t		 in_size;
+	unsigned char	 fingerprint[16];
 };
 
 /* Gzip Filter. */
 static ssize_t	gzip_filter_read(struct archive_read_filter *, const void **);
+static int64_t	gzip_filter_seek(struct archive_read_filter *, int64_t, int);
 static int	gzip_filter_close(struct archive_read_filter *);
+static int	gzip_bidder_options(struct archive_read_filter_bidder *,
+		    struct archive *, const char *, const char *);
+static void	gzip_bidder_free(struct archive_read_filter_bidder *);
 #endif
 
 /*
@@ -89,16 +155,36 @@ static const struct archive_read_filter_bidder_vtable
 gzip_bidder_vtable = {
 	.bid = gzip_bidder_bid,
 	.init = gzip_bidder_init,
+#ifdef HAVE_ZLIB_H
+	.free = gzip_bidder_free,
+	.name = "gzip",
+	.options = gzip_bidder_options,
+#endif
 };
 
 int
 archive_read_support_filter_gzip(struct archive *_a)
 {
 	struct archive_read *a = (struct archive_read *)_a;
+#ifdef HAVE_ZLIB_H
+	struct gzip_bidder_options *options;
 
+	options = calloc(1, sizeof(*options));
+	if (options == NULL) {
+		archive_set_error(_a, ENOMEM,
+		    "Can't allocate data for gzip decompression");
+		return (ARCHIVE_FATAL);
+	}
+	if (__archive_read_register_bidder(a, options,
+				&gzip_bidder_vtable) != ARCHIVE_OK) {
+		free(options);
+		return (ARCHIVE_FATAL);
+	}
+#else
 	if (__archive_read_register_bidder(a, NULL,
 				&gzip_bidder_vtable) != ARCHIVE_OK)
 		return (ARCHIVE_FATAL);
+#endif
 
 	/* Signal the extent of gzip support with the return value here. */
 #if HAVE_ZLIB_H
@@ -293,9 +379,309 @@ gzip_reader_vtable = {
 	.close = gzip_filter_close,
 #ifdef HAVE_ZLIB_H
 	.read_header = gzip_read_header,
+	.seek = gzip_filter_seek,
 #endif
 };
 
+/*
+ * Parse a size with an optional K, M or G suffix.
+ */
+static int
+string_to_size(const char *string, int64_t *numberp)
+{
+	uintmax_t number;
+	char *end;
+	unsigned int shift = 0;
+
+	if (string == NULL || *string == '\0' || *string == '-')
+		return (ARCHIVE_WARN);
+	errno = 0;
+	number = strtoumax(string, &end, 10);
+	if (end > string) {
+		if (*end == 'K' || *end == 'k') {
+			shift = 10;
+			end++;
+		} else if (*end == 'M' || *end == 'm') {
+			shift = 20;
+			end++;
+		} else if (*end == 'G' || *end == 'g') {
+			shift = 30;
+			end++;
+		}
+	}
+	if (end == string || *end != '\0' || errno == ERANGE)
+		return (ARCHIVE_WARN);
+	if (number > ((uintmax_t)INT64_MAX) >> shift)
+		return (ARCHIVE_WARN);
+	*numberp = (int64_t)(number << shift);
+	return (ARCHIVE_OK);
+}
+
+static int
+gzip_bidder_options(struct archive_read_filter_bidder *self,
+    struct archive *a, const char *key, const char *value)
+{
+	struct gzip_bidder_options *options = self->data;
+
+	if (strcmp(key, "checkpoint-interval") == 0) {
+		if (value == NULL) {
+			options->checkpoint_interval = 0;
+			return (ARCHIVE_OK);
+		}
+		if (string_to_size(value, &options->checkpoint_interval)
+		    != ARCHIVE_OK || options->checkpoint_interval <= 0) {
+			options->checkpoint_interval = 0;
+			archive_set_error(a, ARCHIVE_ERRNO_MISC,
+			    "checkpoint-interval invalid");
+			return (ARCHIVE_FAILED);
+		}
+		return (ARCHIVE_OK);
+	} else if (strcmp(key, "index") == 0) {
+		free(options->index_file);
+		options->index_file = NULL;
+		if (value == NULL)
+			return (ARCHIVE_OK);
+		options->index_file = strdup(value);
+		if (options->index_file == NULL) {
+			archive_set_error(a, ENOMEM,
+			    "Can't allocate data for gzip decompression");
+			return (ARCHIVE_FATAL);
+		}
+		return (ARCHIVE_OK);
+	}
+
+	/* Note: The "warn" return is just to inform the options
+	 * supervisor that we didn't handle it.  It will generate
+	 * a suitable error if no one used this option. */
+	return (ARCHIVE_WARN);
+}
+
+static void
+gzip_bidder_free(struct archive_read_filter_bidder *self)
+{
+	struct gzip_bidder_options *options = self->data;
+
+	if (options == NULL)
+		return;
+	free(options->index_file);
+	free(options);
+}
+
+static int
+read_fully(int fd, void *buff, size_t size)
+{
+	unsigned char *p = buff;
+	ssize_t bytes;
+
+	while (size > 0) {
+		bytes = read(fd, p, size);
+		if (bytes <= 0)
+			return (-1);
+		p += bytes;
+		size -= bytes;
+	}
+	return (0);
+}
+
+static int
+write_fully(int fd, const void *buff, size_t size)
+{
+	const unsigned char *p = buff;
+	ssize_t bytes;
+
+	while (size > 0) {
+		bytes = write(fd, p, size);
+		if (bytes <= 0)
+			return (-1);
+		p += bytes;
+		size -= bytes;
+	}
+	return (0);
+}
+
+static void
+free_checkpoints(struct gzip *gzip)
+{
+	size_t i;
+
+	for (i = 0; i < gzip->checkpoints_used; i++)
+		free(gzip->checkpoints[i].window);
+	free(gzip->checkpoints);
+	gzip->checkpoints = NULL;
+	gzip->checkpoints_used = 0;
+	gzip->checkpoints_size = 0;
+}
+
+/*
+ * Append a new, empty checkpoint and return it.
+ */
+static struct gzip_checkpoint *
+new_checkpoint(struct gzip *gzip)
+{
+	struct gzip_checkpoint *cp;
+
+	if (gzip->checkpoints_used >= gzip->checkpoints_size) {
+		size_t new_size = gzip->checkpoints_size * 2;
+
+		if (new_size < 64)
+			new_size = 64;
+		cp = realloc(gzip->checkpoints, new_size * sizeof(*cp));
+		if (cp == NULL)
+			return (NULL);
+		gzip->checkpoints = cp;
+		gzip->checkpoints_size = new_size;
+	}
+	cp = &gzip->checkpoints[gzip->checkpoints_used];
+	memset(cp, 0, sizeof(*cp));
+	cp->window = malloc(GZIP_WINDOW_SIZE);
+	if (cp->window == NULL)
+		return (NULL);
+	gzip->checkpoints_used++;
+	return (cp);
+}
+
+/*
+ * Record what identifies the compressed file, so that an index saved
+ * for an earlier version of it is not applied after it was rewritten.
+ * The first 8 bytes of the gzip header are still buffered from the bid;
+ * the trailer needs a seek to the end and back.  If the input cannot
+ * seek, in_size stays -1 and no index is loaded or saved.
+ */
+static int
+take_fingerprint(struct archive_read_filter *f)
+{
+	struct gzip *gzip = f->data;
+	const unsigned char *p;
+	int64_t end;
+
+	gzip->in_size = -1;
+	if (f->archive->client.seeker == NULL)
+		return (ARCHIVE_OK);
+	p = __archive_read_filter_ahead(f->upstream, 8, NULL);
+	if (p == NULL)
+		return (ARCHIVE_OK);
+	memcpy(gzip->fingerprint, p, 8);
+	end = __archive_read_filter_seek(f->upstream, -8, SEEK_END);
+	if (end < 0)
+		return (ARCHIVE_OK);
+	p = __archive_read_filter_ahead(f->upstream, 8, NULL);
+	if (p != NULL && end >= gzip->start_in) {
+		memcpy(gzip->fingerprint + 8, p, 8);
+		gzip->in_size = end + 8;
+	}
+	if (__archive_read_filter_seek(f->upstream, gzip->start_in,
+	    SEEK_SET) < 0) {
+		archive_set_error(&f->archive->archive, ARCHIVE_ERRNO_MISC,
+		    "Can't seek back to the start of gzip data");
+		return (ARCHIVE_FATAL);
+	}
+	return (ARCHIVE_OK);
+}
+
+/*
+ * Load a checkpoint index written by save_index().  An index that
+ * does not exist yet is not an error; one that cannot be parsed or
+ * that was written for different compressed data is discarded and
+ * rebuilt.
+ *
+ * Layout, all integers little-endian:
+ *   8 bytes magic, 8 bytes start offset, 8 bytes compressed size,
+ *   16 bytes fingerprint, 8 bytes checkpoint count, then for each
+ *   checkpoint: 8 bytes decompressed offset, 8 bytes compressed
+ *   offset, 4 bytes bit count, 4 bytes window size and the window
+ *   itself.
+ */
+static void
+load_index(struct gzip *gzip)
+{
+	struct gzip_checkpoint *cp;
+	unsigned char h[48];
+	uint64_t count, i;
+	int64_t last_out = 0;
+	int fd;
+
+	if (gzip->in_size < 0)
+		return;
+	fd = open(gzip->index_file, O_RDONLY | O_BINARY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	__archive_ensure_cloexec_flag(fd);
+	if (read_fully(fd, h, sizeof(h)) != 0 ||
+	    memcmp(h, GZIP_INDEX_MAGIC, 8) != 0 ||
+	    (int64_t)archive_le64dec(h + 8) != gzip->start_in ||
+	    (int64_t)archive_le64dec(h + 16) != gzip->in_size ||
+	    memcmp(h + 24, gzip->fingerprint, 16) != 0)
+		goto invalid;
+	count = archive_le64dec(h + 40);
+	for (i = 0; i < count; i++) {
+		if (read_fully(fd, h, 24) != 0)
+			goto invalid;
+		if ((cp = new_checkpoint(gzip)) == NULL)
+			goto invalid;
+		cp->out = (int64_t)archive_le64dec(h);
+		cp->in = (int64_t)archive_le64dec(h + 8);
+		cp->bits = (int)archive_le32dec(h + 16);
+		cp->window_size = archive_le32dec(h + 20);
+		if (cp->out <= last_out || cp->in <= gzip->start_in ||
+		    cp->in > gzip->in_size ||
+		    cp->bits < 0 || cp->bits > 7 ||
+		    cp->window_size > GZIP_WINDOW_SIZE ||
+		    read_fully(fd, cp->window, cp->window_size) != 0)
+			goto invalid;
+		last_out = cp->out;
+	}
+	close(fd);
+	gzip->checkpoints_saved = gzip->checkpoints_used;
+	return;
+invalid:
+	close(fd);
+	free_checkpoints(gzip);
+}
+
+static int
+save_index(struct archive_read_filter *f)
+{
+	struct gzip *gzip = f->data;
+	struct gzip_checkpoint *cp;
+	unsigned char h[48];
+	size_t i;
+	int fd;
+
+	fd = open(gzip->index_file,
+	    O_WRONLY | O_CREAT | O_TRUNC | O_BINARY | O_CLOEXEC, 0644);
+	if (fd < 0)
+		goto fail;
+	__archive_ensure_cloexec_flag(fd);
+	memcpy(h, GZIP_INDEX_MAGIC, 8);
+	archive_le64enc(h + 8, (uint64_t)gzip->start_in);
+	archive_le64enc(h + 16, (uint64_t)gzip->in_size);
+	memcpy(h + 24, gzip->fingerprint, 16);
+	archive_le64enc(h + 40, (uint64_t)gzip->checkpoints_used);
+	if (write_fully(fd, h, sizeof(h)) != 0)
+		goto fail;
+	for (i = 0; i < gzip->checkpoints_used; i++) {
+		cp = &gzip->checkpoints[i];
+		archive_le64enc(h, (uint64_t)cp->out);
+		archive_le64enc(h + 8, (uint64_t)cp->in);
+		archive_le32enc(h + 16, (uint32_t)cp->bits);
+		archive_le32enc(h + 20, cp->window_size);
+		if (write_fully(fd, h, 24) != 0 ||
+		    write_fully(fd, cp->window, cp->window_size) != 0)
+			goto fail;
+	}
+	if (close(fd) != 0) {
+		fd = -1;
+		goto fail;
+	}
+	return (ARCHIVE_OK);
+fail:
+	archive_set_error(&f->archive->archive, errno,
+	    "Can't write gzip index %s", gzip->index_file);
+	if (fd >= 0)
+		close(fd);
+	return (ARCHIVE_WARN);
+}
+
 /*
  * Initialize the filter object.
  */
@@ -303,6 +689,7 @@ static int
 gzip_bidder_init(struct archive_read_filter *f)
 {
 	struct gzip *gzip;
+	struct gzip_bidder_options *options;
 	static const size_t out_block_size = 64 * 1024;
 	void *out_block;
 
@@ -326,6 +713,34 @@ gzip_bidder_init(struct archive_read_filter *f)
 
 	gzip->in_stream = 0; /* We're not actually within a stream yet. */
 
+	/* Random access is only offered when the client asked for it,
+	 * and only on top of the client's own (possibly seekable)
+	 * stream. */
+	options = f->bidder->data;
+	if (options != NULL && f->upstream != NULL &&
+	    f->upstream->upstream == NULL &&
+	    (options->checkpoint_interval > 0 ||
+	     options->index_file != NULL)) {
+		gzip->checkpoint_interval = options->checkpoint_interval;
+		if (gzip->checkpoint_interval <= 0)
+			gzip->checkpoint_interval =
+			    GZIP_DEFAULT_CHECKPOINT_INTERVAL;
+		gzip->start_in = f->upstream->position;
+		if (options->index_file != NULL) {
+			gzip->index_file = strdup(options->index_file);
+			if (gzip->index_file == NULL) {
+				archive_set_error(&f->archive->archive, ENOMEM,
+				    "Can't allocate data for gzip "
+				    "decompression");
+				return (ARCHIVE_FATAL);
+			}
+			if (take_fingerprint(f) != ARCHIVE_OK)
+				return (ARCHIVE_FATAL);
+			load_index(gzip);
+		}
+		f->can_seek = 1;
+	}
+
 	return (ARCHIVE_OK);
 }
 
@@ -362,12 +777,16 @@ consume_header(struct archive_read_filter *f)
 	if (avail > max_in)
 		avail = max_in;
 	gzip->stream.avail_in = (uInt)avail;
-	ret = inflateInit2(&(gzip->stream),
-	    -15 /* Don't check for zlib header */);
+	if (gzip->stream_valid)
+		ret = inflateReset(&(gzip->stream));
+	else
+		ret = inflateInit2(&(gzip->stream),
+		    -15 /* Don't check for zlib header */);
 
 	/* Decipher the error code. */
 	switch (ret) {
 	case Z_OK:
+		gzip->stream_valid = 1;
 		gzip->in_stream = 1;
 		return (ARCHIVE_OK);
 	case Z_STREAM_ERROR:
@@ -404,15 +823,6 @@ consume_trailer(struct archive_read_filter *f)
 	const unsigned char *p;
 
 	gzip->in_stream = 0;
-	switch (inflateEnd(&(gzip->stream))) {
-	case Z_OK:
-		break;
-	default:
-		archive_set_error(&f->archive->archive,
-		    ARCHIVE_ERRNO_MISC,
-		    "Failed to clean up gzip decompressor");
-		return (ARCHIVE_FATAL);
-	}
 
 	/* GZip trailer is a fixed 8 byte structure. */
 	p = __archive_read_filter_ahead(f->upstream, 8, NULL);
@@ -427,6 +837,49 @@ consume_trailer(struct archive_read_filter *f)
 	return (ARCHIVE_OK);
 }
 
+/*
+ * Called when inflate stopped at a deflate block boundary; record a
+ * checkpoint there if the last one is far enough behind.
+ */
+static int
+record_checkpoint(struct archive_read_filter *f)
+{
+	struct gzip *gzip = f->data;
+	struct gzip_checkpoint *cp;
+	int64_t out;
+	uInt window_size;
+
+	out = gzip->out_total + (gzip->stream.next_out - gzip->out_block);
+	if (gzip->checkpoints_used == 0) {
+		if (out < gzip->checkpoint_interval)
+			return (ARCHIVE_OK);
+	} else {
+		cp = &gzip->checkpoints[gzip->checkpoints_used - 1];
+		/* After seeking back we pass old checkpoints again. */
+		if (out < cp->out + gzip->checkpoint_interval)
+			return (ARCHIVE_OK);
+	}
+
+	cp = new_checkpoint(gzip);
+	if (cp == NULL) {
+		archive_set_error(&f->archive->archive, ENOMEM,
+		    "Can't allocate data for gzip decompression");
+		return (ARCHIVE_FATAL);
+	}
+	window_size = GZIP_WINDOW_SIZE;
+	if (inflateGetDictionary(&(gzip->stream), cp->window, &window_size)
+	    != Z_OK) {
+		archive_set_error(&f->archive->archive, ARCHIVE_ERRNO_MISC,
+		    "Failed to record gzip checkpoint");
+		return (ARCHIVE_FATAL);
+	}
+	cp->out = out;
+	cp->in = f->upstream->position;
+	cp->bits = gzip->stream.data_type & 7;
+	cp->window_size = window_size;
+	return (ARCHIVE_OK);
+}
+
 static ssize_t
 gzip_filter_read(struct archive_read_filter *f, const void **p)
 {
@@ -435,6 +888,14 @@ gzip_filter_read(struct archive_read_filter *f, const void **p)
 	ssize_t avail_in, max_in;
 	int ret;
 
+	/* Return what is left of the block a seek landed in. */
+	if (gzip->pending_size > 0) {
+		*p = gzip->pending_next;
+		decompressed = gzip->pending_size;
+		gzip->pending_size = 0;
+		return (decompressed);
+	}
+
 	/* Empty our output buffer. */
 	gzip->stream.next_out = gzip->out_block;
 	gzip->stream.avail_out = (uInt)gzip->out_block_size;
@@ -472,12 +933,22 @@ gzip_filter_read(struct archive_read_filter *f, const void **p)
 			avail_in = max_in;
 		gzip->stream.avail_in = (uInt)avail_in;
 
-		/* Decompress and consume some of that data. */
-		ret = inflate(&(gzip->stream), 0);
+		/* Decompress and consume some of that data.  When
+		 * building checkpoints, stop at every block boundary
+		 * so we get a chance to record one there. */
+		ret = inflate(&(gzip->stream),
+		    gzip->checkpoint_interval > 0 ? Z_BLOCK : 0);
 		switch (ret) {
 		case Z_OK: /* Decompressor made some progress. */
 			__archive_read_filter_consume(f->upstream,
 			    avail_in - gzip->stream.avail_in);
+			/* At the end of a block that is not the last? */
+			if (gzip->checkpoint_interval > 0 &&
+			    (gzip->stream.data_type & 0xc0) == 0x80) {
+				ret = record_checkpoint(f);
+				if (ret < ARCHIVE_OK)
+					return (ret);
+			}
 			break;
 		case Z_STREAM_END: /* Found end of stream. */
 			__archive_read_filter_consume(f->upstream,
@@ -499,6 +970,8 @@ gzip_filter_read(struct archive_read_filter *f, const void **p)
 
 	/* We've read as much as we can. */
 	decompressed = gzip->stream.next_out - gzip->out_block;
+	gzip->out_total += decompressed;
+	gzip->out_block_used = decompressed;
 	if (decompressed == 0)
 		*p = NULL;
 	else
@@ -506,6 +979,145 @@ gzip_filter_read(struct archive_read_filter *f, const void **p)
 	return (decompressed);
 }
 
+/*
+ * Restart decompression at a checkpoint, or at the very beginning if
+ * there is none.
+ */
+static int
+gzip_restart(struct archive_read_filter *f, struct gzip_checkpoint *cp)
+{
+	struct gzip *gzip = f->data;
+	const unsigned char *b;
+	int64_t r;
+	int ret, byte = 0;
+
+	if (cp == NULL)
+		r = __archive_read_filter_seek(f->upstream, gzip->start_in,
+		    SEEK_SET);
+	else
+		r = __archive_read_filter_seek(f->upstream,
+		    cp->in - (cp->bits ? 1 : 0), SEEK_SET);
+	if (r < 0) {
+		archive_set_error(&f->archive->archive, ARCHIVE_ERRNO_MISC,
+		    "Cannot reposition gzip input");
+		return ((int)r);
+	}
+
+	gzip->in_stream = 0;
+	gzip->eof = 0;
+	gzip->out_block_used = 0;
+	gzip->pending_size = 0;
+	if (cp == NULL) {
+		/* The next read starts over with the gzip header. */
+		gzip->out_total = 0;
+		return (ARCHIVE_OK);
+	}
+
+	if (cp->bits) {
+		b = __archive_read_filter_ahead(f->upstream, 1, NULL);
+		if (b == NULL) {
+			archive_set_error(&f->archive->archive,
+			    ARCHIVE_ERRNO_MISC, "truncated gzip input");
+			return (ARCHIVE_FATAL);
+		}
+		byte = b[0];
+		__archive_read_filter_consume(f->upstream, 1);
+	}
+	gzip->stream.next_in = NULL;
+	gzip->stream.avail_in = 0;
+	if (gzip->stream_valid)
+		ret = inflateReset(&(gzip->stream));
+	else
+		ret = inflateInit2(&(gzip->stream), -15);
+	if (ret != Z_OK) {
+		archive_set_error(&f->archive->archive, ARCHIVE_ERRNO_MISC,
+		    "Internal error initializing compression library");
+		return (ARCHIVE_FATAL);
+	}
+	gzip->stream_valid = 1;
+	gzip->in_stream = 1;
+	if (cp->bits)
+		ret = inflatePrime(&(gzip->stream), cp->bits,
+		    byte >> (8 - cp->bits));
+	if (ret == Z_OK)
+		ret = inflateSetDictionary(&(gzip->stream), cp->window,
+		    cp->window_size);
+	if (ret != Z_OK) {
+		archive_set_error(&f->archive->archive, ARCHIVE_ERRNO_MISC,
+		    "Failed to restore gzip checkpoint");
+		return (ARCHIVE_FATAL);
+	}
+	gzip->out_total = cp->out;
+	return (ARCHIVE_OK);
+}
+
+static int64_t
+gzip_filter_seek(struct archive_read_filter *f, int64_t offset, int whence)
+{
+	struct gzip *gzip = f->data;
+	struct gzip_checkpoint *cp = NULL;
+	size_t lo, hi, mid;
+	const void *p;
+	ssize_t bytes;
+	int ret;
+
+	if (whence != SEEK_SET || offset < 0) {
+		archive_set_error(&f->archive->archive, ARCHIVE_ERRNO_MISC,
+		    "Unsupported seek in gzip data");
+		return (ARCHIVE_FAILED);
+	}
+
+	/* Still inside the block we returned last? */
+	if (offset < gzip->out_total &&
+	    offset >= gzip->out_total - (int64_t)gzip->out_block_used) {
+		gzip->pending_size = (size_t)(gzip->out_total - offset);
+		gzip->pending_next = gzip->out_block +
+		    gzip->out_block_used - gzip->pending_size;
+		return (offset);
+	}
+
+	/* Find the last checkpoint at or before the target. */
+	lo = 0;
+	hi = gzip->checkpoints_used;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (gzip->checkpoints[mid].out <= offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo > 0)
+		cp = &gzip->checkpoints[lo - 1];
+
+	/* Restart unless simply reading on gets there sooner. */
+	if (offset < gzip->out_total ||
+	    (cp != NULL && cp->out > gzip->out_total)) {
+		ret = gzip_restart(f, cp);
+		if (ret != ARCHIVE_OK)
+			return (ret);
+	}
+	gzip->pending_size = 0;
+
+	/* Decompress and discard up to the target. */
+	while (gzip->out_total < offset) {
+		bytes = gzip_filter_read(f, &p);
+		if (bytes < 0)
+			return (bytes);
+		if (bytes == 0) {
+			archive_set_error(&f->archive->archive,
+			    ARCHIVE_ERRNO_MISC,
+			    "Seek past end of gzip data");
+			return (ARCHIVE_FATAL);
+		}
+	}
+	if (gzip->out_total > offset) {
+		gzip->pending_size = (size_t)(gzip->out_total - offset);
+		gzip->pending_next = gzip->out_block +
+		    gzip->out_block_used - gzip->pending_size;
+	}
+	return (offset);
+}
+
 /*
  * Clean up the decompressor.
  */
@@ -517,7 +1129,7 @@ gzip_filter_close(struct archive_read_filter *f)
 
 	ret = ARCHIVE_OK;
 
-	if (gzip->in_stream) {
+	if (gzip->stream_valid) {
 		switch (inflateEnd(&(gzip->stream))) {
 		case Z_OK:
 			break;
@@ -529,6 +1141,13 @@ gzip_filter_close(struct archive_read_filter *f)
 		}
 	}
 
+	if (gzip->index_file != NULL && gzip->in_size >= 0 &&
+	    gzip->checkpoints_used > gzip->checkpoints_saved &&
+	    save_index(f) != ARCHIVE_OK && ret == ARCHIVE_OK)
+		ret = ARCHIVE_WARN;
+
+	free_checkpoints(gzip);
+	free(gzip->index_file);
 	free(gzip->name);
 	free(gzip->out_block);
 	free(gzip);
@@ -50,17 +50,52 @@
 
 #if HAVE_ZSTD_H && HAVE_LIBZSTD
 
+/*
+ * Zstandard seekable format: the stream ends in a skippable frame
+ * listing the compressed and decompressed size of every frame,
+ * followed by a 9-byte footer.
+ */
+#define SEEKABLE_MAGIC 0x8F92EAB1U
+#define SEEKABLE_SKIPPABLE_MAGIC 0x184D2A5EU
+#define SEEKABLE_FOOTER_SIZE 9
+#define SEEKABLE_MAX_FRAMES 0x8000000U
+
+/* Options set before the filter exists. */
+struct zstd_bidder_options {
+	char		 seekable;
+};
+
 struct zstd {
 	ZSTD_DStream	*dstream;
 	unsigned char	*out_block;
 	size_t		 out_block_size;
 	char		 in_frame; /* True = in the middle of a zstd frame. */
 	char		 eof; /* True = found end of compressed data. */
+
+	/* Decompressed bytes produced so far. */
+	int64_t		 out_total;
+	/* Size of the block most recently returned from out_block. */
+	size_t		 out_block_used;
+	/* Part of out_block still to be returned after a seek. */
+	const unsigned char *pending_next;
+	size_t		 pending_size;
+
+	/* Seek table: frame i starts at compressed offset
+	 * start_in + frame_in[i] and decompressed offset frame_out[i];
+	 * both arrays have an extra entry for the end. */
+	int64_t		 start_in;
+	uint32_t	 frames;
+	int64_t		*frame_in;
+	int64_t		*frame_out;
 };
 
 /* Zstd Filter. */
 static ssize_t	zstd_filter_read(struct archive_read_filter *, const void**);
+static int64_t	zstd_filter_seek(struct archive_read_filter *, int64_t, int);
 static int	zstd_filter_close(struct archive_read_filter *);
+static int	zstd_bidder_options(struct archive_read_filter_bidder *,
+		    struct archive *, const char *, const char *);
+static void	zstd_bidder_free(struct archive_read_filter_bidder *);
 #endif
 
 /*
@@ -76,16 +111,36 @@ static const struct archive_read_filter_bidder_vtable
 zstd_bidder_vtable = {
 	.bid = zstd_bidder_bid,
 	.init = zstd_bidder_init,
+#if HAVE_ZSTD_H && HAVE_LIBZSTD
+	.free = zstd_bidder_free,
+	.name = "zstd",
+	.options = zstd_bidder_options,
+#endif
 };
 
 int
 archive_read_support_filter_zstd(struct archive *_a)
 {
 	struct archive_read *a = (struct archive_read *)_a;
+#if HAVE_ZSTD_H && HAVE_LIBZSTD
+	struct zstd_bidder_options *options;
 
+	options = calloc(1, sizeof(*options));
+	if (options == NULL) {
+		archive_set_error(_a, ENOMEM,
+		    "Can't allocate data for zstd decompression");
+		return (ARCHIVE_FATAL);
+	}
+	if (__archive_read_register_bidder(a, options,
+				&zstd_bidder_vtable) != ARCHIVE_OK) {
+		free(options);
+		return (ARCHIVE_FATAL);
+	}
+#else
 	if (__archive_read_register_bidder(a, NULL,
 				&zstd_bidder_vtable) != ARCHIVE_OK)
 		return (ARCHIVE_FATAL);
+#endif
 
 #if HAVE_ZSTD_H && HAVE_LIBZSTD
 	return (ARCHIVE_OK);
@@ -221,8 +276,109 @@ static const struct archive_read_filter_vtable
 zstd_reader_vtable = {
 	.read = zstd_filter_read,
 	.close = zstd_filter_close,
+	.seek = zstd_filter_seek,
 };
 
+static int
+zstd_bidder_options(struct archive_read_filter_bidder *self,
+    struct archive *a, const char *key, const char *value)
+{
+	struct zstd_bidder_options *options = self->data;
+
+	(void)a; /* UNUSED */
+	if (strcmp(key, "seekable") == 0) {
+		options->seekable = (value != NULL);
+		return (ARCHIVE_OK);
+	}
+
+	/* Note: The "warn" return is just to inform the options
+	 * supervisor that we didn't handle it.  It will generate
+	 * a suitable error if no one used this option. */
+	return (ARCHIVE_WARN);
+}
+
+static void
+zstd_bidder_free(struct archive_read_filter_bidder *self)
+{
+	free(self->data);
+}
+
+/*
+ * Look for a seek table at the end of the input.  This needs a client
+ * seek callback; a missing or malformed table simply leaves the stream
+ * sequential.  Once the input has been repositioned, though, failing
+ * to get back to the start of the data is fatal.
+ */
+static int
+read_seek_table(struct archive_read_filter *f)
+{
+	struct zstd *zstd = f->data;
+	struct archive_read_filter *u = f->upstream;
+	const unsigned char *p;
+	int64_t end, table, in, out;
+	uint32_t frames, i;
+	size_t entry_size;
+
+	zstd->start_in = u->position;
+	end = __archive_read_filter_seek(u, -SEEKABLE_FOOTER_SIZE, SEEK_END);
+	if (end < 0)
+		return (ARCHIVE_OK);
+	end += SEEKABLE_FOOTER_SIZE;
+	p = __archive_read_filter_ahead(u, SEEKABLE_FOOTER_SIZE, NULL);
+	if (p == NULL || archive_le32dec(p + 5) != SEEKABLE_MAGIC ||
+	    (p[4] & 0x7c) != 0)
+		goto done;
+	frames = archive_le32dec(p);
+	entry_size = (p[4] & 0x80) ? 12 : 8;
+	if (frames > SEEKABLE_MAX_FRAMES)
+		goto done;
+
+	/* Skippable frame header, entries, footer. */
+	table = end - SEEKABLE_FOOTER_SIZE - (int64_t)frames * entry_size - 8;
+	if (table < zstd->start_in ||
+	    __archive_read_filter_seek(u, table, SEEK_SET) < 0)
+		goto done;
+	p = __archive_read_filter_ahead(u, 8 + frames * entry_size, NULL);
+	if (p == NULL || archive_le32dec(p) != SEEKABLE_SKIPPABLE_MAGIC ||
+	    archive_le32dec(p + 4) != frames * entry_size +
+	      SEEKABLE_FOOTER_SIZE)
+		goto done;
+	p += 8;
+
+	zstd->frame_in = malloc(((size_t)frames + 1) * sizeof(int64_t));
+	zstd->frame_out = malloc(((size_t)frames + 1) * sizeof(int64_t));
+	if (zstd->frame_in == NULL || zstd->frame_out == NULL)
+		goto fail;
+	in = out = 0;
+	for (i = 0; i < frames; i++, p += entry_size) {
+		zstd->frame_in[i] = in;
+		zstd->frame_out[i] = out;
+		in += archive_le32dec(p);
+		out += archive_le32dec(p + 4);
+	}
+	zstd->frame_in[frames] = in;
+	zstd->frame_out[frames] = out;
+	/* The frames must account for everything before the table. */
+	if (zstd->start_in + in != table)
+		goto fail;
+	zstd->frames = frames;
+	goto done;
+fail:
+	free(zstd->frame_in);
+	free(zstd->frame_out);
+	zstd->frame_in = zstd->frame_out = NULL;
+done:
+	/* Go back to where decompression starts. */
+	if (__archive_read_filter_seek(u, zstd->start_in, SEEK_SET) < 0) {
+		archive_set_error(&f->archive->archive, ARCHIVE_ERRNO_MISC,
+		    "Can't seek back to the start of zstd data");
+		return (ARCHIVE_FATAL);
+	}
+	if (zstd->frame_in != NULL)
+		f->can_seek = 1;
+	return (ARCHIVE_OK);
+}
+
 /*
  * Initialize the filter object
  */
@@ -230,6 +386,7 @@ static int
 zstd_bidder_init(struct archive_read_filter *f)
 {
 	struct zstd *zstd;
+	struct zstd_bidder_options *options = f->bidder->data;
 	size_t out_block_size = ZSTD_DStreamOutSize();
 	void *out_block;
 	ZSTD_DStream *dstream;
@@ -260,6 +417,13 @@ zstd_bidder_init(struct archive_read_filter *f)
 	zstd->eof = 0;
 	zstd->in_frame = 0;
 
+	/* Reading the seek table means a trip to the end of the input,
+	 * so it is only done when the client asked for it. */
+	if (options != NULL && options->seekable &&
+	    f->upstream != NULL && f->upstream->upstream == NULL &&
+	    f->archive->client.seeker != NULL)
+		return (read_seek_table(f));
+
 	return (ARCHIVE_OK);
 }
 
@@ -273,6 +437,14 @@ zstd_filter_read(struct archive_read_filter *f, const void **p)
 	ZSTD_inBuffer in;
 	size_t ret;
 
+	/* Return what is left of the block a seek landed in. */
+	if (zstd->pending_size > 0) {
+		*p = zstd->pending_next;
+		decompressed = zstd->pending_size;
+		zstd->pending_size = 0;
+		return (decompressed);
+	}
+
 	out = (ZSTD_outBuffer) { zstd->out_block, zstd->out_block_size, 0 };
 
 	/* Try to fill the output buffer. */
@@ -327,6 +499,8 @@ zstd_filter_read(struct archive_read_filter *f, const void **p)
 	}
 
 	decompressed = out.pos;
+	zstd->out_total += decompressed;
+	zstd->out_block_used = decompressed;
 	if (decompressed == 0)
 		*p = NULL;
 	else
@@ -334,6 +508,83 @@ zstd_filter_read(struct archive_read_filter *f, const void **p)
 	return (decompressed);
 }
 
+/*
+ * Reposition using the seek table: restart at the frame holding the
+ * target and decompress only the part of it that precedes the target.
+ */
+static int64_t
+zstd_filter_seek(struct archive_read_filter *f, int64_t offset, int whence)
+{
+	struct zstd *zstd = f->data;
+	uint32_t lo, hi, mid;
+	const void *p;
+	ssize_t bytes;
+	int64_t r;
+
+	if (whence != SEEK_SET || offset < 0 ||
+	    offset > zstd->frame_out[zstd->frames]) {
+		archive_set_error(&f->archive->archive, ARCHIVE_ERRNO_MISC,
+		    "Unsupported seek in zstd data");
+		return (ARCHIVE_FAILED);
+	}
+
+	/* Still inside the block we returned last? */
+	if (offset < zstd->out_total &&
+	    offset >= zstd->out_total - (int64_t)zstd->out_block_used) {
+		zstd->pending_size = (size_t)(zstd->out_total - offset);
+		zstd->pending_next = zstd->out_block +
+		    zstd->out_block_used - zstd->pending_size;
+		return (offset);
+	}
+
+	/* Find the last frame starting at or before the target. */
+	lo = 0;
+	hi = zstd->frames;
+	while (lo < hi) {
+		mid = lo + (hi - lo + 1) / 2;
+		if (zstd->frame_out[mid] <= offset)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	/* Restart unless simply reading on gets there sooner. */
+	if (offset < zstd->out_total || zstd->frame_out[lo] > zstd->out_total) {
+		r = __archive_read_filter_seek(f->upstream,
+		    zstd->start_in + zstd->frame_in[lo], SEEK_SET);
+		if (r < 0) {
+			archive_set_error(&f->archive->archive,
+			    ARCHIVE_ERRNO_MISC,
+			    "Cannot reposition zstd input");
+			return (r);
+		}
+		zstd->in_frame = 0;
+		zstd->eof = 0;
+		zstd->out_total = zstd->frame_out[lo];
+		zstd->out_block_used = 0;
+	}
+	zstd->pending_size = 0;
+
+	/* Decompress and discard up to the target. */
+	while (zstd->out_total < offset) {
+		bytes = zstd_filter_read(f, &p);
+		if (bytes < 0)
+			return (bytes);
+		if (bytes == 0) {
+			archive_set_error(&f->archive->archive,
+			    ARCHIVE_ERRNO_MISC,
+			    "Seek past end of zstd data");
+			return (ARCHIVE_FATAL);
+		}
+	}
+	if (zstd->out_total > offset) {
+		zstd->pending_size = (size_t)(zstd->out_total - offset);
+		zstd->pending_next = zstd->out_block +
+		    zstd->out_block_used - zstd->pending_size;
+	}
+	return (offset);
+}
+
 /*
  * Clean up the decompressor.
  */
@@ -343,6 +594,8 @@ zstd_filter_close(struct archive_read_filter *f)
 	struct zstd *zstd = f->data;
 
 	ZSTD_freeDStream(zstd->dstream);
+	free(zstd->frame_in);
+	free(zstd->frame_out);
 	free(zstd->out_block);
 	free(zstd);
 
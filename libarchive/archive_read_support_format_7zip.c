@@ -51,6 +51,7 @@
 #endif
 
 #include "archive.h"
+#include "archive_bcj_private.h"
 #include "archive_entry.h"
 #include "archive_entry_locale.h"
 #include "archive_integer.h"
@@ -497,7 +498,8 @@ archive_read_support_format_7zip(struct archive *_a)
 	    NULL,
 	    archive_read_format_7zip_cleanup,
 	    archive_read_support_format_7zip_capabilities,
-	    archive_read_format_7zip_has_encrypted_entries);
+	    archive_read_format_7zip_has_encrypted_entries,
+	    NULL);
 
 	if (r != ARCHIVE_OK)
 		free(zip);
@@ -4189,9 +4191,7 @@ x86_Convert(struct _7zip *zip, uint8_t *data, size_t size)
 		uint8_t *p = data + bufferPos;
 		uint8_t *limit = data + size - 4;
 
-		for (; p < limit; p++)
-			if ((*p & 0xFE) == 0xE8)
-				break;
+		p = __archive_bcj_find_e8(p, limit, 1);
 		bufferPos = (size_t)(p - data);
 		if (p >= limit)
 			break;
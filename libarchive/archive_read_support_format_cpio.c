@@ -183,6 +183,10 @@ struct cpio {
 	int64_t			  entry_bytes_unconsumed;
 	int64_t			  entry_offset;
 	int64_t			  entry_padding;
+	/* Where the body of the entry starts, for archive_seek_data(). */
+	int64_t			  entry_data_start;
+	int64_t			  entry_data_size;
+	int64_t			  entry_data_padding;
 
 	struct archive_string_conv *opt_sconv;
 	struct archive_string_conv *sconv_default;
@@ -202,6 +206,8 @@ static int	archive_read_format_cpio_read_data(struct archive_read *,
 		    const void **, size_t *, int64_t *);
 static int	archive_read_format_cpio_read_header(struct archive_read *,
 		    struct archive_entry *);
+static int64_t	archive_read_format_cpio_seek_data(struct archive_read *,
+		    int64_t, int);
 static int	archive_read_format_cpio_skip(struct archive_read *);
 static int64_t	cpio_be32dec(const unsigned char *);
 static int64_t	cpio_le32dec(const unsigned char *);
@@ -247,9 +253,10 @@ archive_read_support_format_cpio(struct archive *_a)
 	    archive_read_format_cpio_read_header,
 	    archive_read_format_cpio_read_data,
 	    archive_read_format_cpio_skip,
-	    NULL,
+	    archive_read_format_cpio_seek_data,
 	    archive_read_format_cpio_cleanup,
 	    NULL,
+	    NULL,
 	    NULL);
 
 	if (r != ARCHIVE_OK)
@@ -457,6 +464,10 @@ archive_read_format_cpio_read_header(struct archive_read *a,
 		return (ARCHIVE_EOF);
 	}
 
+	cpio->entry_data_start = a->filter->position;
+	cpio->entry_data_size = cpio->entry_bytes_remaining;
+	cpio->entry_data_padding = cpio->entry_padding;
+
 	/* Detect and record hardlinks to previously-extracted entries. */
 	if (record_hardlink(a, cpio, entry) != ARCHIVE_OK) {
 		return (ARCHIVE_FATAL);
@@ -518,6 +529,65 @@ archive_read_format_cpio_skip(struct archive_read *a)
 	return (ARCHIVE_OK);
 }
 
+/*
+ * cpio bodies are stored contiguously, so any offset maps directly
+ * to a position in the archive.  Seeking forward just skips,
+ * seeking backward requires a seekable input.
+ */
+static int64_t
+archive_read_format_cpio_seek_data(struct archive_read *a, int64_t offset,
+    int whence)
+{
+	struct cpio *cpio = a->format->data;
+	int64_t target, clamped, r;
+
+	switch (whence) {
+	case SEEK_SET:
+		target = offset;
+		break;
+	case SEEK_CUR:
+		target = cpio->entry_offset + offset;
+		break;
+	case SEEK_END:
+		target = cpio->entry_data_size + offset;
+		break;
+	default:
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Invalid whence value %d", whence);
+		return (ARCHIVE_FAILED);
+	}
+	if (target < 0) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Attempt to seek before the start of the entry");
+		return (ARCHIVE_FAILED);
+	}
+	clamped = target < cpio->entry_data_size ?
+	    target : cpio->entry_data_size;
+
+	/* Bytes handed out but not yet consumed are still buffered,
+	 * so a short step backward never needs to seek. */
+	r = __archive_read_reposition(a, cpio->entry_data_start + clamped);
+	if (r == ARCHIVE_FAILED) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Cannot seek backward in this archive"
+		    " (input is not seekable)");
+		return (ARCHIVE_FAILED);
+	}
+	if (r < 0)
+		return (ARCHIVE_FATAL);
+
+	cpio->entry_bytes_unconsumed = 0;
+	cpio->entry_offset = clamped;
+	cpio->entry_bytes_remaining = cpio->entry_data_size - clamped;
+	cpio->entry_padding = cpio->entry_data_padding;
+
+	/* Restart archive_read_data() at the new offset. */
+	__archive_reset_read_data(&a->archive);
+	a->archive.read_data_offset = clamped;
+	a->archive.read_data_output_offset = clamped;
+	return (target);
+}
+
 /*
  * Skip forward to the next cpio newc header by searching for the
  * 07070[12] string.  This should be generalized and merged with
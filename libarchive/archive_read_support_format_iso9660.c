@@ -488,6 +488,7 @@ archive_read_support_format_iso9660(struct archive *_a)
 	    NULL,
 	    archive_read_format_iso9660_cleanup,
 	    NULL,
+	    NULL,
 	    NULL);
 
 	if (r != ARCHIVE_OK)
@@ -282,6 +282,7 @@ archive_read_support_format_lha(struct archive *_a)
 	    NULL,
 	    archive_read_format_lha_cleanup,
 	    NULL,
+	    NULL,
 	    NULL);
 
 	if (r != ARCHIVE_OK)
@@ -1726,7 +1727,7 @@ lha_calcsum(unsigned char sum, const void *pp, int offset, size_t size)
 	return (sum);
 }
 
-static const uint16_t crc16tbl[2][256] = {
+static const uint16_t crc16tbl[8][256] = {
 	{
 		0x0000, 0xc0c1, 0xc181, 0x0140, 0xc301, 0x03c0, 0x0280,
 		0xc241, 0xc601, 0x06c0, 0x0780, 0xc741, 0x0500, 0xc5c1,
@@ -1804,6 +1805,240 @@ static const uint16_t crc16tbl[2][256] = {
 		0xa04d, 0x304c, 0x0044, 0x9045, 0x6045, 0xf044, 0xc046,
 		0x5047, 0xa047, 0x3046, 0xc043, 0x5042, 0xa042, 0x3043,
 		0x0041, 0x9040, 0x6040, 0xf041
+	},
+	{
+		0x0000, 0xc051, 0xc0a1, 0x00f0, 0xc141, 0x0110, 0x01e0,
+		0xc1b1, 0xc281, 0x02d0, 0x0220, 0xc271, 0x03c0, 0xc391,
+		0xc361, 0x0330, 0xc501, 0x0550, 0x05a0, 0xc5f1, 0x0440,
+		0xc411, 0xc4e1, 0x04b0, 0x0780, 0xc7d1, 0xc721, 0x0770,
+		0xc6c1, 0x0690, 0x0660, 0xc631, 0xca01, 0x0a50, 0x0aa0,
+		0xcaf1, 0x0b40, 0xcb11, 0xcbe1, 0x0bb0, 0x0880, 0xc8d1,
+		0xc821, 0x0870, 0xc9c1, 0x0990, 0x0960, 0xc931, 0x0f00,
+		0xcf51, 0xcfa1, 0x0ff0, 0xce41, 0x0e10, 0x0ee0, 0xceb1,
+		0xcd81, 0x0dd0, 0x0d20, 0xcd71, 0x0cc0, 0xcc91, 0xcc61,
+		0x0c30, 0xd401, 0x1450, 0x14a0, 0xd4f1, 0x1540, 0xd511,
+		0xd5e1, 0x15b0, 0x1680, 0xd6d1, 0xd621, 0x1670, 0xd7c1,
+		0x1790, 0x1760, 0xd731, 0x1100, 0xd151, 0xd1a1, 0x11f0,
+		0xd041, 0x1010, 0x10e0, 0xd0b1, 0xd381, 0x13d0, 0x1320,
+		0xd371, 0x12c0, 0xd291, 0xd261, 0x1230, 0x1e00, 0xde51,
+		0xdea1, 0x1ef0, 0xdf41, 0x1f10, 0x1fe0, 0xdfb1, 0xdc81,
+		0x1cd0, 0x1c20, 0xdc71, 0x1dc0, 0xdd91, 0xdd61, 0x1d30,
+		0xdb01, 0x1b50, 0x1ba0, 0xdbf1, 0x1a40, 0xda11, 0xdae1,
+		0x1ab0, 0x1980, 0xd9d1, 0xd921, 0x1970, 0xd8c1, 0x1890,
+		0x1860, 0xd831, 0xe801, 0x2850, 0x28a0, 0xe8f1, 0x2940,
+		0xe911, 0xe9e1, 0x29b0, 0x2a80, 0xead1, 0xea21, 0x2a70,
+		0xebc1, 0x2b90, 0x2b60, 0xeb31, 0x2d00, 0xed51, 0xeda1,
+		0x2df0, 0xec41, 0x2c10, 0x2ce0, 0xecb1, 0xef81, 0x2fd0,
+		0x2f20, 0xef71, 0x2ec0, 0xee91, 0xee61, 0x2e30, 0x2200,
+		0xe251, 0xe2a1, 0x22f0, 0xe341, 0x2310, 0x23e0, 0xe3b1,
+		0xe081, 0x20d0, 0x2020, 0xe071, 0x21c0, 0xe191, 0xe161,
+		0x2130, 0xe701, 0x2750, 0x27a0, 0xe7f1, 0x2640, 0xe611,
+		0xe6e1, 0x26b0, 0x2580, 0xe5d1, 0xe521, 0x2570, 0xe4c1,
+		0x2490, 0x2460, 0xe431, 0x3c00, 0xfc51, 0xfca1, 0x3cf0,
+		0xfd41, 0x3d10, 0x3de0, 0xfdb1, 0xfe81, 0x3ed0, 0x3e20,
+		0xfe71, 0x3fc0, 0xff91, 0xff61, 0x3f30, 0xf901, 0x3950,
+		0x39a0, 0xf9f1, 0x3840, 0xf811, 0xf8e1, 0x38b0, 0x3b80,
+		0xfbd1, 0xfb21, 0x3b70, 0xfac1, 0x3a90, 0x3a60, 0xfa31,
+		0xf601, 0x3650, 0x36a0, 0xf6f1, 0x3740, 0xf711, 0xf7e1,
+		0x37b0, 0x3480, 0xf4d1, 0xf421, 0x3470, 0xf5c1, 0x3590,
+		0x3560, 0xf531, 0x3300, 0xf351, 0xf3a1, 0x33f0, 0xf241,
+		0x3210, 0x32e0, 0xf2b1, 0xf181, 0x31d0, 0x3120, 0xf171,
+		0x30c0, 0xf091, 0xf061, 0x3030
+	},
+	{
+		0x0000, 0xfc01, 0xb801, 0x4400, 0x3001, 0xcc00, 0x8800,
+		0x7401, 0x6002, 0x9c03, 0xd803, 0x2402, 0x5003, 0xac02,
+		0xe802, 0x1403, 0xc004, 0x3c05, 0x7805, 0x8404, 0xf005,
+		0x0c04, 0x4804, 0xb405, 0xa006, 0x5c07, 0x1807, 0xe406,
+		0x9007, 0x6c06, 0x2806, 0xd407, 0xc00b, 0x3c0a, 0x780a,
+		0x840b, 0xf00a, 0x0c0b, 0x480b, 0xb40a, 0xa009, 0x5c08,
+		0x1808, 0xe409, 0x9008, 0x6c09, 0x2809, 0xd408, 0x000f,
+		0xfc0e, 0xb80e, 0x440f, 0x300e, 0xcc0f, 0x880f, 0x740e,
+		0x600d, 0x9c0c, 0xd80c, 0x240d, 0x500c, 0xac0d, 0xe80d,
+		0x140c, 0xc015, 0x3c14, 0x7814, 0x8415, 0xf014, 0x0c15,
+		0x4815, 0xb414, 0xa017, 0x5c16, 0x1816, 0xe417, 0x9016,
+		0x6c17, 0x2817, 0xd416, 0x0011, 0xfc10, 0xb810, 0x4411,
+		0x3010, 0xcc11, 0x8811, 0x7410, 0x6013, 0x9c12, 0xd812,
+		0x2413, 0x5012, 0xac13, 0xe813, 0x1412, 0x001e, 0xfc1f,
+		0xb81f, 0x441e, 0x301f, 0xcc1e, 0x881e, 0x741f, 0x601c,
+		0x9c1d, 0xd81d, 0x241c, 0x501d, 0xac1c, 0xe81c, 0x141d,
+		0xc01a, 0x3c1b, 0x781b, 0x841a, 0xf01b, 0x0c1a, 0x481a,
+		0xb41b, 0xa018, 0x5c19, 0x1819, 0xe418, 0x9019, 0x6c18,
+		0x2818, 0xd419, 0xc029, 0x3c28, 0x7828, 0x8429, 0xf028,
+		0x0c29, 0x4829, 0xb428, 0xa02b, 0x5c2a, 0x182a, 0xe42b,
+		0x902a, 0x6c2b, 0x282b, 0xd42a, 0x002d, 0xfc2c, 0xb82c,
+		0x442d, 0x302c, 0xcc2d, 0x882d, 0x742c, 0x602f, 0x9c2e,
+		0xd82e, 0x242f, 0x502e, 0xac2f, 0xe82f, 0x142e, 0x0022,
+		0xfc23, 0xb823, 0x4422, 0x3023, 0xcc22, 0x8822, 0x7423,
+		0x6020, 0x9c21, 0xd821, 0x2420, 0x5021, 0xac20, 0xe820,
+		0x1421, 0xc026, 0x3c27, 0x7827, 0x8426, 0xf027, 0x0c26,
+		0x4826, 0xb427, 0xa024, 0x5c25, 0x1825, 0xe424, 0x9025,
+		0x6c24, 0x2824, 0xd425, 0x003c, 0xfc3d, 0xb83d, 0x443c,
+		0x303d, 0xcc3c, 0x883c, 0x743d, 0x603e, 0x9c3f, 0xd83f,
+		0x243e, 0x503f, 0xac3e, 0xe83e, 0x143f, 0xc038, 0x3c39,
+		0x7839, 0x8438, 0xf039, 0x0c38, 0x4838, 0xb439, 0xa03a,
+		0x5c3b, 0x183b, 0xe43a, 0x903b, 0x6c3a, 0x283a, 0xd43b,
+		0xc037, 0x3c36, 0x7836, 0x8437, 0xf036, 0x0c37, 0x4837,
+		0xb436, 0xa035, 0x5c34, 0x1834, 0xe435, 0x9034, 0x6c35,
+		0x2835, 0xd434, 0x0033, 0xfc32, 0xb832, 0x4433, 0x3032,
+		0xcc33, 0x8833, 0x7432, 0x6031, 0x9c30, 0xd830, 0x2431,
+		0x5030, 0xac31, 0xe831, 0x1430
+	},
+	{
+		0x0000, 0xc03d, 0xc079, 0x0044, 0xc0f1, 0x00cc, 0x0088,
+		0xc0b5, 0xc1e1, 0x01dc, 0x0198, 0xc1a5, 0x0110, 0xc12d,
+		0xc169, 0x0154, 0xc3c1, 0x03fc, 0x03b8, 0xc385, 0x0330,
+		0xc30d, 0xc349, 0x0374, 0x0220, 0xc21d, 0xc259, 0x0264,
+		0xc2d1, 0x02ec, 0x02a8, 0xc295, 0xc781, 0x07bc, 0x07f8,
+		0xc7c5, 0x0770, 0xc74d, 0xc709, 0x0734, 0x0660, 0xc65d,
+		0xc619, 0x0624, 0xc691, 0x06ac, 0x06e8, 0xc6d5, 0x0440,
+		0xc47d, 0xc439, 0x0404, 0xc4b1, 0x048c, 0x04c8, 0xc4f5,
+		0xc5a1, 0x059c, 0x05d8, 0xc5e5, 0x0550, 0xc56d, 0xc529,
+		0x0514, 0xcf01, 0x0f3c, 0x0f78, 0xcf45, 0x0ff0, 0xcfcd,
+		0xcf89, 0x0fb4, 0x0ee0, 0xcedd, 0xce99, 0x0ea4, 0xce11,
+		0x0e2c, 0x0e68, 0xce55, 0x0cc0, 0xccfd, 0xccb9, 0x0c84,
+		0xcc31, 0x0c0c, 0x0c48, 0xcc75, 0xcd21, 0x0d1c, 0x0d58,
+		0xcd65, 0x0dd0, 0xcded, 0xcda9, 0x0d94, 0x0880, 0xc8bd,
+		0xc8f9, 0x08c4, 0xc871, 0x084c, 0x0808, 0xc835, 0xc961,
+		0x095c, 0x0918, 0xc925, 0x0990, 0xc9ad, 0xc9e9, 0x09d4,
+		0xcb41, 0x0b7c, 0x0b38, 0xcb05, 0x0bb0, 0xcb8d, 0xcbc9,
+		0x0bf4, 0x0aa0, 0xca9d, 0xcad9, 0x0ae4, 0xca51, 0x0a6c,
+		0x0a28, 0xca15, 0xde01, 0x1e3c, 0x1e78, 0xde45, 0x1ef0,
+		0xdecd, 0xde89, 0x1eb4, 0x1fe0, 0xdfdd, 0xdf99, 0x1fa4,
+		0xdf11, 0x1f2c, 0x1f68, 0xdf55, 0x1dc0, 0xddfd, 0xddb9,
+		0x1d84, 0xdd31, 0x1d0c, 0x1d48, 0xdd75, 0xdc21, 0x1c1c,
+		0x1c58, 0xdc65, 0x1cd0, 0xdced, 0xdca9, 0x1c94, 0x1980,
+		0xd9bd, 0xd9f9, 0x19c4, 0xd971, 0x194c, 0x1908, 0xd935,
+		0xd861, 0x185c, 0x1818, 0xd825, 0x1890, 0xd8ad, 0xd8e9,
+		0x18d4, 0xda41, 0x1a7c, 0x1a38, 0xda05, 0x1ab0, 0xda8d,
+		0xdac9, 0x1af4, 0x1ba0, 0xdb9d, 0xdbd9, 0x1be4, 0xdb51,
+		0x1b6c, 0x1b28, 0xdb15, 0x1100, 0xd13d, 0xd179, 0x1144,
+		0xd1f1, 0x11cc, 0x1188, 0xd1b5, 0xd0e1, 0x10dc, 0x1098,
+		0xd0a5, 0x1010, 0xd02d, 0xd069, 0x1054, 0xd2c1, 0x12fc,
+		0x12b8, 0xd285, 0x1230, 0xd20d, 0xd249, 0x1274, 0x1320,
+		0xd31d, 0xd359, 0x1364, 0xd3d1, 0x13ec, 0x13a8, 0xd395,
+		0xd681, 0x16bc, 0x16f8, 0xd6c5, 0x1670, 0xd64d, 0xd609,
+		0x1634, 0x1760, 0xd75d, 0xd719, 0x1724, 0xd791, 0x17ac,
+		0x17e8, 0xd7d5, 0x1540, 0xd57d, 0xd539, 0x1504, 0xd5b1,
+		0x158c, 0x15c8, 0xd5f5, 0xd4a1, 0x149c, 0x14d8, 0xd4e5,
+		0x1450, 0xd46d, 0xd429, 0x1414
+	},
+	{
+		0x0000, 0xd101, 0xe201, 0x3300, 0x8401, 0x5500, 0x6600,
+		0xb701, 0x4801, 0x9900, 0xaa00, 0x7b01, 0xcc00, 0x1d01,
+		0x2e01, 0xff00, 0x9002, 0x4103, 0x7203, 0xa302, 0x1403,
+		0xc502, 0xf602, 0x2703, 0xd803, 0x0902, 0x3a02, 0xeb03,
+		0x5c02, 0x8d03, 0xbe03, 0x6f02, 0x6007, 0xb106, 0x8206,
+		0x5307, 0xe406, 0x3507, 0x0607, 0xd706, 0x2806, 0xf907,
+		0xca07, 0x1b06, 0xac07, 0x7d06, 0x4e06, 0x9f07, 0xf005,
+		0x2104, 0x1204, 0xc305, 0x7404, 0xa505, 0x9605, 0x4704,
+		0xb804, 0x6905, 0x5a05, 0x8b04, 0x3c05, 0xed04, 0xde04,
+		0x0f05, 0xc00e, 0x110f, 0x220f, 0xf30e, 0x440f, 0x950e,
+		0xa60e, 0x770f, 0x880f, 0x590e, 0x6a0e, 0xbb0f, 0x0c0e,
+		0xdd0f, 0xee0f, 0x3f0e, 0x500c, 0x810d, 0xb20d, 0x630c,
+		0xd40d, 0x050c, 0x360c, 0xe70d, 0x180d, 0xc90c, 0xfa0c,
+		0x2b0d, 0x9c0c, 0x4d0d, 0x7e0d, 0xaf0c, 0xa009, 0x7108,
+		0x4208, 0x9309, 0x2408, 0xf509, 0xc609, 0x1708, 0xe808,
+		0x3909, 0x0a09, 0xdb08, 0x6c09, 0xbd08, 0x8e08, 0x5f09,
+		0x300b, 0xe10a, 0xd20a, 0x030b, 0xb40a, 0x650b, 0x560b,
+		0x870a, 0x780a, 0xa90b, 0x9a0b, 0x4b0a, 0xfc0b, 0x2d0a,
+		0x1e0a, 0xcf0b, 0xc01f, 0x111e, 0x221e, 0xf31f, 0x441e,
+		0x951f, 0xa61f, 0x771e, 0x881e, 0x591f, 0x6a1f, 0xbb1e,
+		0x0c1f, 0xdd1e, 0xee1e, 0x3f1f, 0x501d, 0x811c, 0xb21c,
+		0x631d, 0xd41c, 0x051d, 0x361d, 0xe71c, 0x181c, 0xc91d,
+		0xfa1d, 0x2b1c, 0x9c1d, 0x4d1c, 0x7e1c, 0xaf1d, 0xa018,
+		0x7119, 0x4219, 0x9318, 0x2419, 0xf518, 0xc618, 0x1719,
+		0xe819, 0x3918, 0x0a18, 0xdb19, 0x6c18, 0xbd19, 0x8e19,
+		0x5f18, 0x301a, 0xe11b, 0xd21b, 0x031a, 0xb41b, 0x651a,
+		0x561a, 0x871b, 0x781b, 0xa91a, 0x9a1a, 0x4b1b, 0xfc1a,
+		0x2d1b, 0x1e1b, 0xcf1a, 0x0011, 0xd110, 0xe210, 0x3311,
+		0x8410, 0x5511, 0x6611, 0xb710, 0x4810, 0x9911, 0xaa11,
+		0x7b10, 0xcc11, 0x1d10, 0x2e10, 0xff11, 0x9013, 0x4112,
+		0x7212, 0xa313, 0x1412, 0xc513, 0xf613, 0x2712, 0xd812,
+		0x0913, 0x3a13, 0xeb12, 0x5c13, 0x8d12, 0xbe12, 0x6f13,
+		0x6016, 0xb117, 0x8217, 0x5316, 0xe417, 0x3516, 0x0616,
+		0xd717, 0x2817, 0xf916, 0xca16, 0x1b17, 0xac16, 0x7d17,
+		0x4e17, 0x9f16, 0xf014, 0x2115, 0x1215, 0xc314, 0x7415,
+		0xa514, 0x9614, 0x4715, 0xb815, 0x6914, 0x5a14, 0x8b15,
+		0x3c14, 0xed15, 0xde15, 0x0f14
+	},
+	{
+		0x0000, 0xc010, 0xc023, 0x0033, 0xc045, 0x0055, 0x0066,
+		0xc076, 0xc089, 0x0099, 0x00aa, 0xc0ba, 0x00cc, 0xc0dc,
+		0xc0ef, 0x00ff, 0xc111, 0x0101, 0x0132, 0xc122, 0x0154,
+		0xc144, 0xc177, 0x0167, 0x0198, 0xc188, 0xc1bb, 0x01ab,
+		0xc1dd, 0x01cd, 0x01fe, 0xc1ee, 0xc221, 0x0231, 0x0202,
+		0xc212, 0x0264, 0xc274, 0xc247, 0x0257, 0x02a8, 0xc2b8,
+		0xc28b, 0x029b, 0xc2ed, 0x02fd, 0x02ce, 0xc2de, 0x0330,
+		0xc320, 0xc313, 0x0303, 0xc375, 0x0365, 0x0356, 0xc346,
+		0xc3b9, 0x03a9, 0x039a, 0xc38a, 0x03fc, 0xc3ec, 0xc3df,
+		0x03cf, 0xc441, 0x0451, 0x0462, 0xc472, 0x0404, 0xc414,
+		0xc427, 0x0437, 0x04c8, 0xc4d8, 0xc4eb, 0x04fb, 0xc48d,
+		0x049d, 0x04ae, 0xc4be, 0x0550, 0xc540, 0xc573, 0x0563,
+		0xc515, 0x0505, 0x0536, 0xc526, 0xc5d9, 0x05c9, 0x05fa,
+		0xc5ea, 0x059c, 0xc58c, 0xc5bf, 0x05af, 0x0660, 0xc670,
+		0xc643, 0x0653, 0xc625, 0x0635, 0x0606, 0xc616, 0xc6e9,
+		0x06f9, 0x06ca, 0xc6da, 0x06ac, 0xc6bc, 0xc68f, 0x069f,
+		0xc771, 0x0761, 0x0752, 0xc742, 0x0734, 0xc724, 0xc717,
+		0x0707, 0x07f8, 0xc7e8, 0xc7db, 0x07cb, 0xc7bd, 0x07ad,
+		0x079e, 0xc78e, 0xc881, 0x0891, 0x08a2, 0xc8b2, 0x08c4,
+		0xc8d4, 0xc8e7, 0x08f7, 0x0808, 0xc818, 0xc82b, 0x083b,
+		0xc84d, 0x085d, 0x086e, 0xc87e, 0x0990, 0xc980, 0xc9b3,
+		0x09a3, 0xc9d5, 0x09c5, 0x09f6, 0xc9e6, 0xc919, 0x0909,
+		0x093a, 0xc92a, 0x095c, 0xc94c, 0xc97f, 0x096f, 0x0aa0,
+		0xcab0, 0xca83, 0x0a93, 0xcae5, 0x0af5, 0x0ac6, 0xcad6,
+		0xca29, 0x0a39, 0x0a0a, 0xca1a, 0x0a6c, 0xca7c, 0xca4f,
+		0x0a5f, 0xcbb1, 0x0ba1, 0x0b92, 0xcb82, 0x0bf4, 0xcbe4,
+		0xcbd7, 0x0bc7, 0x0b38, 0xcb28, 0xcb1b, 0x0b0b, 0xcb7d,
+		0x0b6d, 0x0b5e, 0xcb4e, 0x0cc0, 0xccd0, 0xcce3, 0x0cf3,
+		0xcc85, 0x0c95, 0x0ca6, 0xccb6, 0xcc49, 0x0c59, 0x0c6a,
+		0xcc7a, 0x0c0c, 0xcc1c, 0xcc2f, 0x0c3f, 0xcdd1, 0x0dc1,
+		0x0df2, 0xcde2, 0x0d94, 0xcd84, 0xcdb7, 0x0da7, 0x0d58,
+		0xcd48, 0xcd7b, 0x0d6b, 0xcd1d, 0x0d0d, 0x0d3e, 0xcd2e,
+		0xcee1, 0x0ef1, 0x0ec2, 0xced2, 0x0ea4, 0xceb4, 0xce87,
+		0x0e97, 0x0e68, 0xce78, 0xce4b, 0x0e5b, 0xce2d, 0x0e3d,
+		0x0e0e, 0xce1e, 0x0ff0, 0xcfe0, 0xcfd3, 0x0fc3, 0xcfb5,
+		0x0fa5, 0x0f96, 0xcf86, 0xcf79, 0x0f69, 0x0f5a, 0xcf4a,
+		0x0f3c, 0xcf2c, 0xcf1f, 0x0f0f
+	},
+	{
+		0x0000, 0xccc1, 0xd981, 0x1540, 0xf301, 0x3fc0, 0x2a80,
+		0xe641, 0xa601, 0x6ac0, 0x7f80, 0xb341, 0x5500, 0x99c1,
+		0x8c81, 0x4040, 0x0c01, 0xc0c0, 0xd580, 0x1941, 0xff00,
+		0x33c1, 0x2681, 0xea40, 0xaa00, 0x66c1, 0x7381, 0xbf40,
+		0x5901, 0x95c0, 0x8080, 0x4c41, 0x1802, 0xd4c3, 0xc183,
+		0x0d42, 0xeb03, 0x27c2, 0x3282, 0xfe43, 0xbe03, 0x72c2,
+		0x6782, 0xab43, 0x4d02, 0x81c3, 0x9483, 0x5842, 0x1403,
+		0xd8c2, 0xcd82, 0x0143, 0xe702, 0x2bc3, 0x3e83, 0xf242,
+		0xb202, 0x7ec3, 0x6b83, 0xa742, 0x4103, 0x8dc2, 0x9882,
+		0x5443, 0x3004, 0xfcc5, 0xe985, 0x2544, 0xc305, 0x0fc4,
+		0x1a84, 0xd645, 0x9605, 0x5ac4, 0x4f84, 0x8345, 0x6504,
+		0xa9c5, 0xbc85, 0x7044, 0x3c05, 0xf0c4, 0xe584, 0x2945,
+		0xcf04, 0x03c5, 0x1685, 0xda44, 0x9a04, 0x56c5, 0x4385,
+		0x8f44, 0x6905, 0xa5c4, 0xb084, 0x7c45, 0x2806, 0xe4c7,
+		0xf187, 0x3d46, 0xdb07, 0x17c6, 0x0286, 0xce47, 0x8e07,
+		0x42c6, 0x5786, 0x9b47, 0x7d06, 0xb1c7, 0xa487, 0x6846,
+		0x2407, 0xe8c6, 0xfd86, 0x3147, 0xd706, 0x1bc7, 0x0e87,
+		0xc246, 0x8206, 0x4ec7, 0x5b87, 0x9746, 0x7107, 0xbdc6,
+		0xa886, 0x6447, 0x6008, 0xacc9, 0xb989, 0x7548, 0x9309,
+		0x5fc8, 0x4a88, 0x8649, 0xc609, 0x0ac8, 0x1f88, 0xd349,
+		0x3508, 0xf9c9, 0xec89, 0x2048, 0x6c09, 0xa0c8, 0xb588,
+		0x7949, 0x9f08, 0x53c9, 0x4689, 0x8a48, 0xca08, 0x06c9,
+		0x1389, 0xdf48, 0x3909, 0xf5c8, 0xe088, 0x2c49, 0x780a,
+		0xb4cb, 0xa18b, 0x6d4a, 0x8b0b, 0x47ca, 0x528a, 0x9e4b,
+		0xde0b, 0x12ca, 0x078a, 0xcb4b, 0x2d0a, 0xe1cb, 0xf48b,
+		0x384a, 0x740b, 0xb8ca, 0xad8a, 0x614b, 0x870a, 0x4bcb,
+		0x5e8b, 0x924a, 0xd20a, 0x1ecb, 0x0b8b, 0xc74a, 0x210b,
+		0xedca, 0xf88a, 0x344b, 0x500c, 0x9ccd, 0x898d, 0x454c,
+		0xa30d, 0x6fcc, 0x7a8c, 0xb64d, 0xf60d, 0x3acc, 0x2f8c,
+		0xe34d, 0x050c, 0xc9cd, 0xdc8d, 0x104c, 0x5c0d, 0x90cc,
+		0x858c, 0x494d, 0xaf0c, 0x63cd, 0x768d, 0xba4c, 0xfa0c,
+		0x36cd, 0x238d, 0xef4c, 0x090d, 0xc5cc, 0xd08c, 0x1c4d,
+		0x480e, 0x84cf, 0x918f, 0x5d4e, 0xbb0f, 0x77ce, 0x628e,
+		0xae4f, 0xee0f, 0x22ce, 0x378e, 0xfb4f, 0x1d0e, 0xd1cf,
+		0xc48f, 0x084e, 0x440f, 0x88ce, 0x9d8e, 0x514f, 0xb70e,
+		0x7bcf, 0x6e8f, 0xa24e, 0xe20e, 0x2ecf, 0x3b8f, 0xf74e,
+		0x110f, 0xddce, 0xc88e, 0x044f
 	}
 };
 
@@ -1811,60 +2046,22 @@ static uint16_t
 lha_crc16(uint16_t crc, const void *pp, size_t len)
 {
 	const unsigned char *p = (const unsigned char *)pp;
-	const uint16_t *buff;
-	const union {
-		uint32_t i;
-		char c[4];
-	} u = { 0x01020304 };
-
-	if (len == 0)
-		return crc;
 
-	/* Process unaligned address. */
-	if (((uintptr_t)p) & (uintptr_t)0x1) {
-		crc = (crc >> 8) ^ crc16tbl[0][(crc ^ *p++) & 0xff];
-		len--;
-	}
-	buff = (const uint16_t *)p;
 	/*
-	 * Modern C compiler such as GCC does not unroll automatically yet
-	 * without unrolling pragma, and Clang is so. So we should
-	 * unroll this loop for its performance.
+	 * Slice-by-8: crc16tbl[k] gives the CRC contribution of a byte
+	 * followed by k zero bytes, so eight input bytes are folded in
+	 * with independent table lookups instead of a serial chain.
+	 * Reading bytes individually keeps this independent of
+	 * alignment and byte order.
 	 */
-	for (;len >= 8; len -= 8) {
-		/* This if statement expects compiler optimization will
-		 * remove the statement which will not be executed. */
-#undef bswap16
-#ifndef __has_builtin
-#define __has_builtin(x) 0
-#endif
-#if defined(_MSC_VER) && _MSC_VER >= 1400  /* Visual Studio */
-#  define bswap16(x) _byteswap_ushort(x)
-#elif defined(__GNUC__) && ((__GNUC__ == 4 && __GNUC_MINOR__ >= 8) || __GNUC__ > 4)
-/* GCC 4.8 and later has __builtin_bswap16() */
-#  define bswap16(x) __builtin_bswap16(x)
-#elif defined(__clang__) && __has_builtin(__builtin_bswap16)
-/* Newer clang versions have __builtin_bswap16() */
-#  define bswap16(x) __builtin_bswap16(x)
-#else
-#  define bswap16(x) ((((x) >> 8) & 0xff) | ((x) << 8))
-#endif
-#define CRC16W	do { 	\
-		if(u.c[0] == 1) { /* Big endian */		\
-			crc ^= bswap16(*buff); buff++;		\
-		} else						\
-			crc ^= *buff++;				\
-		crc = crc16tbl[1][crc & 0xff] ^ crc16tbl[0][crc >> 8];\
-} while (0)
-		CRC16W;
-		CRC16W;
-		CRC16W;
-		CRC16W;
-#undef CRC16W
-#undef bswap16
+	for (;len >= 8; len -= 8, p += 8) {
+		crc = crc16tbl[7][(crc ^ p[0]) & 0xff] ^
+		    crc16tbl[6][((crc >> 8) ^ p[1]) & 0xff] ^
+		    crc16tbl[5][p[2]] ^ crc16tbl[4][p[3]] ^
+		    crc16tbl[3][p[4]] ^ crc16tbl[2][p[5]] ^
+		    crc16tbl[1][p[6]] ^ crc16tbl[0][p[7]];
 	}
 
-	p = (const unsigned char *)buff;
 	for (;len; len--) {
 		crc = (crc >> 8) ^ crc16tbl[0][(crc ^ *p++) & 0xff];
 	}
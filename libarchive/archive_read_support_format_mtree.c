@@ -243,6 +243,7 @@ archive_read_support_format_mtree(struct archive *_a)
 	    NULL,
 	    cleanup,
 	    NULL,
+	    NULL,
 	    NULL);
 
 	if (r != ARCHIVE_OK)
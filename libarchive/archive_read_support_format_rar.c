@@ -36,6 +36,7 @@
 #endif
 
 #include "archive.h"
+#include "archive_bcj_private.h"
 
 #include "archive_endian.h"
 #include "archive_entry.h"
@@ -162,9 +163,6 @@
 #undef minimum
 #define minimum(a, b)	((a)<(b)?(a):(b))
 
-/* Stack overflow check */
-#define MAX_COMPRESS_DEPTH 1024
-
 /* Fields common to all headers */
 struct rar_header
 {
@@ -416,11 +414,13 @@ static int read_symlink_stored(struct archive_read *, struct archive_entry *,
 static int read_data_stored(struct archive_read *, const void **, size_t *,
                             int64_t *);
 static int read_data_compressed(struct archive_read *, const void **, size_t *,
-                                int64_t *, size_t);
+                                int64_t *);
 static int rar_br_preparation(struct archive_read *, struct rar_br *);
 static int parse_codes(struct archive_read *);
 static void free_codes(struct archive_read *);
-static int read_next_symbol(struct archive_read *, struct huffman_code *);
+static inline int read_next_symbol(struct archive_read *,
+                                   struct huffman_code *);
+static int read_next_symbol_slow(struct archive_read *, struct huffman_code *);
 static int create_code(struct archive_read *, struct huffman_code *,
                        unsigned char *, int, char);
 static int add_value(struct archive_read *, struct huffman_code *, int, int,
@@ -691,8 +691,11 @@ lzss_emit_match(struct rar *rar, int offset, int length)
     }
     d = &(rar->lzss.window[dstoffs]);
     s = &(rar->lzss.window[srcoffs]);
-    if ((dstoffs + l < srcoffs) || (srcoffs + l < dstoffs))
-      memcpy(d, s, l);
+    /* A source less than 'l' bytes behind the destination must be
+     * copied forward a byte at a time so that the bytes just written
+     * are repeated; anything else can go through memmove(). */
+    if (srcoffs > dstoffs || dstoffs - srcoffs >= l)
+      memmove(d, s, l);
     else {
       for (li = 0; li < l; li++)
         d[li] = s[li];
@@ -757,7 +760,8 @@ archive_read_support_format_rar(struct archive *_a)
       archive_read_format_rar_seek_data,
       archive_read_format_rar_cleanup,
       archive_read_support_format_rar_capabilities,
-      archive_read_format_rar_has_encrypted_entries);
+      archive_read_format_rar_has_encrypted_entries,
+      NULL);
 
   if (r != ARCHIVE_OK)
     free(rar);
@@ -1129,7 +1133,7 @@ archive_read_format_rar_read_data(struct archive_read *a, const void **buff,
   case COMPRESS_METHOD_NORMAL:
   case COMPRESS_METHOD_GOOD:
   case COMPRESS_METHOD_BEST:
-    ret = read_data_compressed(a, buff, size, offset, 0);
+    ret = read_data_compressed(a, buff, size, offset);
     if (ret != ARCHIVE_OK && ret != ARCHIVE_WARN) {
       __archive_ppmd7_functions.Ppmd7_Free(&rar->ppmd7_context);
       rar->start_new_table = 1;
@@ -2046,11 +2050,8 @@ read_data_stored(struct archive_read *a, const void **buff, size_t *size,
 
 static int
 read_data_compressed(struct archive_read *a, const void **buff, size_t *size,
-                     int64_t *offset, size_t looper)
+                     int64_t *offset)
 {
-  if (looper++ > MAX_COMPRESS_DEPTH)
-    return (ARCHIVE_FAILED);
-
   struct rar *rar = a->format->data;
   int64_t start, end;
   size_t bs;
@@ -2156,19 +2157,33 @@ read_data_compressed(struct archive_read *a, const void **buff, size_t *size,
 
     if (rar->is_ppmd_block)
     {
-      if ((sym = __archive_ppmd7_functions.Ppmd7_DecodeSymbol(
-        &rar->ppmd7_context, &rar->range_dec.p)) < 0)
-      {
-        archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
-                          "Invalid symbol");
-        return (ARCHIVE_FAILED);
-      }
-      if(sym != rar->ppmd_escape)
+      /*
+       * Decode a run of plain literals before going back around the
+       * outer loop, bounded so that the run fits into unp_buffer, does
+       * not wrap the window over uncopied bytes and does not go past
+       * the end of the entry.
+       */
+      bs = rar->unp_buffer_size - rar->unp_offset;
+      if (bs > (size_t)lzss_size(&rar->lzss))
+        bs = lzss_size(&rar->lzss);
+      if (rar->offset < rar->unp_size &&
+          (uint64_t)(rar->unp_size - rar->offset) < bs)
+        bs = (size_t)(rar->unp_size - rar->offset);
+      do
       {
+        if ((sym = __archive_ppmd7_functions.Ppmd7_DecodeSymbol(
+          &rar->ppmd7_context, &rar->range_dec.p)) < 0)
+        {
+          archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
+                            "Invalid symbol");
+          return (ARCHIVE_FAILED);
+        }
+        if (sym == rar->ppmd_escape)
+          break;
         lzss_emit_literal(rar, sym);
         rar->bytes_uncopied++;
-      }
-      else
+      } while (rar->valid && (size_t)rar->bytes_uncopied < bs);
+      if(sym == rar->ppmd_escape)
       {
         if ((code = __archive_ppmd7_functions.Ppmd7_DecodeSymbol(
           &rar->ppmd7_context, &rar->range_dec.p)) < 0)
@@ -2180,13 +2195,16 @@ read_data_compressed(struct archive_read *a, const void **buff, size_t *size,
 
         switch(code)
         {
+          /* Both of these go through the copy below first, so that the
+           * literals decoded above reach unp_buffer before parse_codes()
+           * can reallocate the window or the end of data is reported. */
           case 0:
             rar->start_new_table = 1;
-            return read_data_compressed(a, buff, size, offset, looper);
+            break;
 
           case 2:
             rar->ppmd_eod = 1;/* End Of ppmd Data. */
-            continue;
+            break;
 
           case 3:
             archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
@@ -2602,8 +2620,31 @@ free_codes(struct archive_read *a)
 }
 
 
-static int
+/*
+ * Decode one symbol.  Codes that fit in the lookup table are resolved
+ * here with a single peek; building the table, refilling the bit cache,
+ * longer codes and errors are all left to read_next_symbol_slow().
+ */
+static inline int
 read_next_symbol(struct archive_read *a, struct huffman_code *code)
+{
+  struct rar_br *br = &(((struct rar *)(a->format->data))->br);
+  unsigned int bits;
+
+  if (code->table && rar_br_has(br, code->tablesize))
+  {
+    bits = rar_br_bits(br, code->tablesize);
+    if (code->table[bits].length <= (unsigned int)code->tablesize)
+    {
+      rar_br_consume(br, code->table[bits].length);
+      return code->table[bits].value;
+    }
+  }
+  return read_next_symbol_slow(a, code);
+}
+
+static int
+read_next_symbol_slow(struct archive_read *a, struct huffman_code *code)
 {
   struct rar *rar = a->format->data;
   unsigned char bit;
@@ -3747,23 +3788,26 @@ execute_filter_e8(struct rar_filter *filter, struct rar_virtual_machine *vm, siz
 {
   uint32_t length = filter->initialregisters[4];
   uint32_t filesize = 0x1000000;
-  uint32_t i;
+  uint32_t currpos, i;
+  int32_t address;
 
   if (length > PROGRAM_WORK_SIZE || length <= 4)
     return 0;
 
   for (i = 0; i <= length - 5; i++)
   {
-    if (vm->memory[i] == 0xE8 || (e9also && vm->memory[i] == 0xE9))
-    {
-      uint32_t currpos = (uint32_t)pos + i + 1;
-      int32_t address = (int32_t)vm_read_32(vm, i + 1);
-      if (address < 0 && currpos >= (~(uint32_t)address + 1))
-        vm_write_32(vm, i + 1, address + filesize);
-      else if (address >= 0 && (uint32_t)address < filesize)
-        vm_write_32(vm, i + 1, address - currpos);
-      i += 4;
-    }
+    i = (uint32_t)(__archive_bcj_find_e8(&vm->memory[i],
+      &vm->memory[length - 4], e9also) - vm->memory);
+    if (i > length - 5)
+      break;
+
+    currpos = (uint32_t)pos + i + 1;
+    address = (int32_t)vm_read_32(vm, i + 1);
+    if (address < 0 && currpos >= (~(uint32_t)address + 1))
+      vm_write_32(vm, i + 1, address + filesize);
+    else if (address >= 0 && (uint32_t)address < filesize)
+      vm_write_32(vm, i + 1, address - currpos);
+    i += 4;
   }
 
   filter->filteredblockaddress = 0;
@@ -38,6 +38,7 @@
 #endif
 
 #include "archive.h"
+#include "archive_bcj_private.h"
 
 
 #include "archive_entry.h"
@@ -237,6 +238,7 @@ struct comp_state {
 	uint8_t* window_buf;         /* Circular buffer used during
 	                                decompression. */
 	uint8_t* filtered_buf;       /* Buffer used when applying filters. */
+	size_t filtered_buf_size;    /* Allocated size of filtered_buf. */
 	const uint8_t* block_buf;    /* Buffer used when merging blocks. */
 	ssize_t window_mask;         /* Convenience field; window_size - 1. */
 	int64_t write_ptr;           /* This amount of data has been unpacked
@@ -324,6 +326,7 @@ struct generic_header {
 struct multivolume {
 	unsigned int expected_vol_no;
 	uint8_t* push_buf;
+	size_t push_buf_size;
 };
 
 /* Main context structure. */
@@ -540,13 +543,6 @@ static void circular_memcpy(uint8_t* dst, uint8_t* window, const ssize_t mask,
 	}
 }
 
-static uint32_t read_filter_data(struct rar5 *rar5, uint32_t offset) {
-	uint8_t linear_buf[4];
-	circular_memcpy(linear_buf, rar5->cstate.window_buf,
-	    rar5->cstate.window_mask, offset, offset + 4);
-	return archive_le32dec(linear_buf);
-}
-
 static void write_filter_data(struct rar5 *rar5, uint32_t offset,
     uint32_t value)
 {
@@ -598,6 +594,8 @@ static int run_e8e9_filter(struct rar5 *rar5, struct filter_info* flt,
 		int extended)
 {
 	const uint32_t file_size = 0x1000000;
+	uint8_t* buf = rar5->cstate.filtered_buf;
+	uint32_t addr, offset;
 	ssize_t i;
 
 	circular_memcpy(rar5->cstate.filtered_buf,
@@ -605,39 +603,38 @@ static int run_e8e9_filter(struct rar5 *rar5, struct filter_info* flt,
 	    rar5->cstate.solid_offset + flt->block_start,
 	    rar5->cstate.solid_offset + flt->block_start + flt->block_length);
 
+	/* The scan runs over the linear copy in `filtered_buf`.  Every
+	 * converted address is skipped right after it is written, so the
+	 * bytes examined are always still the unfiltered ones. */
 	for(i = 0; i < flt->block_length - 4;) {
-		uint8_t b = rar5->cstate.window_buf[
-		    (rar5->cstate.solid_offset + flt->block_start +
-		    i++) & rar5->cstate.window_mask];
-
 		/*
 		 * 0xE8 = x86's call <relative_addr_uint32> (function call)
 		 * 0xE9 = x86's jmp <relative_addr_uint32> (unconditional jump)
 		 */
-		if(b == 0xE8 || (extended && b == 0xE9)) {
+		i = __archive_bcj_find_e8(buf + i,
+		    buf + flt->block_length - 4, extended) - buf;
 
-			uint32_t addr;
-			uint32_t offset = (i + flt->block_start) % file_size;
+		if(i >= flt->block_length - 4)
+			break;
+		i++;
 
-			addr = read_filter_data(rar5,
-			    (uint32_t)(rar5->cstate.solid_offset +
-			    flt->block_start + i) & rar5->cstate.window_mask);
+		offset = (i + flt->block_start) % file_size;
+		addr = archive_le32dec(&buf[i]);
 
-			if(addr & 0x80000000) {
-				if(((addr + offset) & 0x80000000) == 0) {
-					write_filter_data(rar5, (uint32_t)i,
-					    addr + file_size);
-				}
-			} else {
-				if((addr - file_size) & 0x80000000) {
-					uint32_t naddr = addr - offset;
-					write_filter_data(rar5, (uint32_t)i,
-					    naddr);
-				}
+		if(addr & 0x80000000) {
+			if(((addr + offset) & 0x80000000) == 0) {
+				write_filter_data(rar5, (uint32_t)i,
+				    addr + file_size);
+			}
+		} else {
+			if((addr - file_size) & 0x80000000) {
+				uint32_t naddr = addr - offset;
+				write_filter_data(rar5, (uint32_t)i,
+				    naddr);
 			}
-
-			i += 4;
 		}
+
+		i += 4;
 	}
 
 	return ARCHIVE_OK;
@@ -653,15 +650,11 @@ static int run_arm_filter(struct rar5 *rar5, struct filter_info* flt) {
 	    rar5->cstate.solid_offset + flt->block_start + flt->block_length);
 
 	for(i = 0; i < flt->block_length - 3; i += 4) {
-		uint8_t* b = &rar5->cstate.window_buf[
-		    (rar5->cstate.solid_offset +
-		    flt->block_start + i + 3) & rar5->cstate.window_mask];
+		uint8_t* b = &rar5->cstate.filtered_buf[i];
 
-		if(*b == 0xEB) {
+		if(b[3] == 0xEB) {
 			/* 0xEB = ARM's BL (branch + link) instruction. */
-			offset = read_filter_data(rar5,
-			    (rar5->cstate.solid_offset + flt->block_start + i) &
-			     (uint32_t)rar5->cstate.window_mask) & 0x00ffffff;
+			offset = archive_le32dec(b) & 0x00ffffff;
 
 			offset -= (uint32_t) ((i + flt->block_start) / 4);
 			offset = (offset & 0x00ffffff) | 0xeb000000;
@@ -677,13 +670,20 @@ static int run_filter(struct archive_read* a, struct filter_info* flt) {
 	int ret;
 
 	clear_data_ready_stack(rar5);
-	free(rar5->cstate.filtered_buf);
 
-	rar5->cstate.filtered_buf = malloc(flt->block_length);
-	if(!rar5->cstate.filtered_buf) {
-		archive_set_error(&a->archive, ENOMEM,
-		    "Can't allocate memory for filter data");
-		return ARCHIVE_FATAL;
+	/* Big files run a filter every few dozen kilobytes, and every file
+	 * of the archive uses the same buffer, so only ever grow it. */
+	if((size_t)flt->block_length > rar5->cstate.filtered_buf_size) {
+		free(rar5->cstate.filtered_buf);
+		rar5->cstate.filtered_buf_size = 0;
+
+		rar5->cstate.filtered_buf = malloc(flt->block_length);
+		if(!rar5->cstate.filtered_buf) {
+			archive_set_error(&a->archive, ENOMEM,
+			    "Can't allocate memory for filter data");
+			return ARCHIVE_FATAL;
+		}
+		rar5->cstate.filtered_buf_size = flt->block_length;
 	}
 
 	switch(flt->type) {
@@ -1363,7 +1363,7 @@ static int parse_file_extra_version(struct archive_read* a,
 	archive_strcat(&name_utf8_string, version_string.s);
 
 	/* Apply the new filename into this file's context. */
-	archive_entry_update_pathname_utf8(e, name_utf8_string.s);
+	archive_entry_set_pathname_utf8(e, name_utf8_string.s);
 
 	/* Free buffers. */
 	archive_string_free(&version_string);
@@ -1503,7 +1503,7 @@ static int parse_file_extra_redir(struct archive_read* a,
 		case REDIR_TYPE_UNIXSYMLINK:
 		case REDIR_TYPE_WINSYMLINK:
 			archive_entry_set_filetype(e, AE_IFLNK);
-			archive_entry_update_symlink_utf8(e, target_utf8_buf);
+			archive_entry_set_symlink_utf8(e, target_utf8_buf);
 			if (rar5->file.redir_flags & REDIR_SYMLINK_IS_DIR) {
 				archive_entry_set_symlink_type(e,
 					AE_SYMLINK_TYPE_DIRECTORY);
@@ -1515,7 +1515,7 @@ static int parse_file_extra_redir(struct archive_read* a,
 
 		case REDIR_TYPE_HARDLINK:
 			archive_entry_set_filetype(e, AE_IFREG);
-			archive_entry_update_hardlink_utf8(e, target_utf8_buf);
+			archive_entry_set_hardlink_utf8(e, target_utf8_buf);
 			break;
 
 		default:
@@ -2010,7 +2010,7 @@ static int process_head_file(struct archive_read* a, struct rar5 *rar5,
 		return ARCHIVE_EOF;
 	}
 
-	archive_entry_update_pathname_utf8(entry, name_utf8_buf);
+	archive_entry_set_pathname_utf8(entry, name_utf8_buf);
 
 	if(extra_data_size > 0) {
 		int ret = process_head_file_extra(a, entry, rar5,
@@ -2608,19 +2608,15 @@ static int init_unpack(struct rar5 *rar5) {
 	init_window_mask(rar5);
 
 	free(rar5->cstate.window_buf);
-	free(rar5->cstate.filtered_buf);
 
 	rar5->cstate.window_buf = NULL;
-	rar5->cstate.filtered_buf = NULL;
 
+	/* filtered_buf is not reset here: run_filter() sizes it for each
+	 * filter, and nothing reads it before a filter has written it. */
 	if(rar5->cstate.window_size > 0) {
 		rar5->cstate.window_buf = calloc(1, rar5->cstate.window_size);
 		if(rar5->cstate.window_buf == NULL)
 			return ARCHIVE_FATAL;
-		rar5->cstate.filtered_buf = calloc(1,
-		    rar5->cstate.window_size);
-		if(rar5->cstate.filtered_buf == NULL)
-			return ARCHIVE_FATAL;
 	}
 
 	clear_data_ready_stack(rar5);
@@ -2744,27 +2740,14 @@ static int create_decode_tables(uint8_t* bit_length,
 	return ARCHIVE_OK;
 }
 
-static int decode_number(struct archive_read* a, struct decode_table* table,
-    const uint8_t* p, uint16_t* num)
+/* Codes longer than the quick table covers; kept out of line so that
+ * decode_number() stays small enough to inline. */
+static uint16_t decode_number_slow(struct rar5 *rar5,
+    const struct decode_table* table, uint16_t bitfield)
 {
-	struct rar5 *rar5 = a->format->data;
-	int i, bits, dist, ret;
-	uint16_t bitfield;
+	int i, bits, dist;
 	uint32_t pos;
 
-	if(ARCHIVE_OK != (ret = read_bits_16(a, rar5, p, &bitfield))) {
-		return ret;
-	}
-
-	bitfield &= 0xfffe;
-
-	if(bitfield < table->decode_len[table->quick_bits]) {
-		int code = bitfield >> (16 - table->quick_bits);
-		skip_bits(rar5, table->quick_len[code]);
-		*num = table->quick_num[code];
-		return ARCHIVE_OK;
-	}
-
 	bits = 15;
 
 	for(i = table->quick_bits + 1; i < 15; i++) {
@@ -2783,7 +2766,30 @@ static int decode_number(struct archive_read* a, struct decode_table* table,
 	if(pos >= table->size)
 		pos = 0;
 
-	*num = table->decode_num[pos];
+	return table->decode_num[pos];
+}
+
+static inline int decode_number(struct archive_read* a,
+    struct decode_table* table, const uint8_t* p, uint16_t* num)
+{
+	struct rar5 *rar5 = a->format->data;
+	int ret;
+	uint16_t bitfield;
+
+	if(ARCHIVE_OK != (ret = read_bits_16(a, rar5, p, &bitfield))) {
+		return ret;
+	}
+
+	bitfield &= 0xfffe;
+
+	if(bitfield < table->decode_len[table->quick_bits]) {
+		int code = bitfield >> (16 - table->quick_bits);
+		skip_bits(rar5, table->quick_len[code]);
+		*num = table->quick_num[code];
+		return ARCHIVE_OK;
+	}
+
+	*num = decode_number_slow(rar5, table, bitfield);
 	return ARCHIVE_OK;
 }
 
@@ -3169,6 +3175,7 @@ static int copy_string(struct archive_read* a, int len, int dist) {
 	const ssize_t cmask = rar5->cstate.window_mask;
 	const uint64_t write_ptr = rar5->cstate.write_ptr +
 	    rar5->cstate.solid_offset;
+	ssize_t src_idx, dst_idx;
 	int i;
 
 	if (rar5->cstate.window_buf == NULL)
@@ -3181,18 +3188,34 @@ static int copy_string(struct archive_read* a, int len, int dist) {
 		return rar5->main.solid ? ARCHIVE_FATAL : ARCHIVE_FAILED;
 	}
 
-	/* The unpacker spends most of the time in this function. It would be
-	 * a good idea to introduce some optimizations here.
+	/* The unpacker spends most of the time in this function.
 	 *
-	 * Just remember that this loop treats buffers that overlap differently
-	 * than buffers that do not overlap. This is why a simple memcpy(3)
-	 * call will not be enough. */
-
-	for(i = 0; i < len; i++) {
-		const ssize_t write_idx = (write_ptr + i) & cmask;
-		const ssize_t read_idx = (write_ptr + i - dist) & cmask;
-		rar5->cstate.window_buf[write_idx] =
-		    rar5->cstate.window_buf[read_idx];
+	 * Remember that the copy runs forward one byte at a time: when the
+	 * source starts less than `len` bytes behind the destination, the
+	 * bytes just written are read again, repeating the pattern.  That
+	 * is why memmove(3) is only used when the ranges are
+	 * disjoint or the source lies ahead of the destination. */
+
+	src_idx = (write_ptr - dist) & cmask;
+	dst_idx = write_ptr & cmask;
+	if(dst_idx + len <= cmask + 1 && src_idx + len <= cmask + 1) {
+		/* Neither range wraps around the end of the window. */
+		uint8_t* dst = &rar5->cstate.window_buf[dst_idx];
+		const uint8_t* src = &rar5->cstate.window_buf[src_idx];
+
+		if(src > dst || dst - src >= len) {
+			memmove(dst, src, len);
+		} else {
+			for(i = 0; i < len; i++)
+				dst[i] = src[i];
+		}
+	} else {
+		for(i = 0; i < len; i++) {
+			const ssize_t write_idx = (write_ptr + i) & cmask;
+			const ssize_t read_idx = (write_ptr + i - dist) & cmask;
+			rar5->cstate.window_buf[write_idx] =
+			    rar5->cstate.window_buf[read_idx];
+		}
 	}
 
 	rar5->cstate.write_ptr += len;
@@ -3569,20 +3592,26 @@ static int merge_block(struct archive_read* a, ssize_t block_size,
 	/* Set a flag that we're in the switching mode. */
 	rar5->cstate.switch_multivolume = 1;
 
-	/* Reallocate the memory which will hold the whole block. */
-	if(rar5->vol.push_buf)
-		free((void*) rar5->vol.push_buf);
-
-	/* Increasing the allocation block by 8 is due to bit reading functions,
-	 * which are using additional 2 or 4 bytes. Allocating the block size
-	 * by exact value would make bit reader perform reads from invalid
-	 * memory block when reading the last byte from the buffer. */
-	rar5->vol.push_buf = malloc(block_size + 8);
-	if(!rar5->vol.push_buf) {
-		archive_set_error(&a->archive, ENOMEM,
-		    "Can't allocate memory for a merge block buffer");
-		rar5->cstate.switch_multivolume = 0;
-		return ARCHIVE_FATAL;
+	/* Reallocate the memory which will hold the whole block. Every
+	 * volume boundary of a multivolume set ends up here, so keep the
+	 * buffer between merges and only grow it. */
+	if((size_t)block_size + 8 > rar5->vol.push_buf_size) {
+		free(rar5->vol.push_buf);
+		rar5->vol.push_buf_size = 0;
+
+		/* Increasing the allocation block by 8 is due to bit reading
+		 * functions, which are using additional 2 or 4 bytes.
+		 * Allocating the block size by exact value would make bit
+		 * reader perform reads from invalid memory block when reading
+		 * the last byte from the buffer. */
+		rar5->vol.push_buf = malloc(block_size + 8);
+		if(!rar5->vol.push_buf) {
+			archive_set_error(&a->archive, ENOMEM,
+			    "Can't allocate memory for a merge block buffer");
+			rar5->cstate.switch_multivolume = 0;
+			return ARCHIVE_FATAL;
+		}
+		rar5->vol.push_buf_size = block_size + 8;
 	}
 
 	/* Valgrind complains if the extension block for bit reader is not
@@ -4510,7 +4539,8 @@ int archive_read_support_format_rar5(struct archive *_a) {
 	    rar5_seek_data,
 	    rar5_cleanup,
 	    rar5_capabilities,
-	    rar5_has_encrypted_entries);
+	    rar5_has_encrypted_entries,
+	    NULL);
 
 	if(r != ARCHIVE_OK) {
 		rar5_deinit(rar5);
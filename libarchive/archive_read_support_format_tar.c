@@ -114,6 +114,9 @@ struct sparse_block {
 	struct sparse_block	*next;
 	int64_t	offset;
 	int64_t	remaining;
+	/* Original extent, kept so archive_seek_data() can rewind. */
+	int64_t	start;
+	int64_t	size;
 	int hole;
 };
 
@@ -137,6 +140,10 @@ struct tar {
 	int64_t			 pax_size;
 	struct sparse_block	*sparse_list;
 	struct sparse_block	*sparse_last;
+	struct sparse_block	*sparse_cursor;
+	int64_t			 entry_data_start;
+	int64_t			 entry_data_size;
+	int64_t			 entry_data_padding;
 	int64_t			 sparse_offset;
 	int64_t			 sparse_numbytes;
 	int			 sparse_gnu_major;
@@ -209,6 +216,10 @@ static int	archive_read_format_tar_cleanup(struct archive_read *);
 static int	archive_read_format_tar_read_data(struct archive_read *a,
 		    const void **buff, size_t *size, int64_t *offset);
 static int	archive_read_format_tar_skip(struct archive_read *a);
+static int64_t	archive_read_format_tar_seek_data(struct archive_read *,
+		    int64_t, int);
+static int	archive_read_format_tar_seek_header(struct archive_read *,
+		    int64_t);
 static int	archive_read_format_tar_read_header(struct archive_read *,
 		    struct archive_entry *);
 static int	checksum(struct archive_read *, const void *);
@@ -288,10 +299,11 @@ archive_read_support_format_tar(struct archive *_a)
 	    archive_read_format_tar_read_header,
 	    archive_read_format_tar_read_data,
 	    archive_read_format_tar_skip,
-	    NULL,
+	    archive_read_format_tar_seek_data,
 	    archive_read_format_tar_cleanup,
 	    NULL,
-	    NULL);
+	    NULL,
+	    archive_read_format_tar_seek_header);
 
 	if (r != ARCHIVE_OK)
 		free(tar);
@@ -599,6 +611,12 @@ archive_read_format_tar_read_header(struct archive_read *a,
 			}
 		}
 	}
+
+	/* Remember where the body starts for archive_seek_data(). */
+	tar->sparse_cursor = tar->sparse_list;
+	tar->entry_data_start = a->filter->position;
+	tar->entry_data_size = tar->entry_bytes_remaining;
+	tar->entry_data_padding = tar->entry_padding;
 	return (r);
 }
 
@@ -608,16 +626,13 @@ archive_read_format_tar_read_data(struct archive_read *a,
 {
 	struct tar *tar = a->format->data;
 	ssize_t bytes_read;
-	struct sparse_block *p;
 
 	for (;;) {
-		/* Remove exhausted entries from sparse list. */
-		while (tar->sparse_list != NULL &&
-		    tar->sparse_list->remaining == 0) {
-			p = tar->sparse_list;
-			tar->sparse_list = p->next;
-			free(p);
-		}
+		/* Step past exhausted entries in the sparse list; they
+		 * stay allocated so that archive_seek_data() can go back. */
+		while (tar->sparse_cursor != NULL &&
+		    tar->sparse_cursor->remaining == 0)
+			tar->sparse_cursor = tar->sparse_cursor->next;
 
 		if (tar->entry_bytes_unconsumed) {
 			__archive_read_consume(a, tar->entry_bytes_unconsumed);
@@ -625,7 +640,7 @@ archive_read_format_tar_read_data(struct archive_read *a,
 		}
 
 		/* If we're at end of file, return EOF. */
-		if (tar->sparse_list == NULL ||
+		if (tar->sparse_cursor == NULL ||
 		    tar->entry_bytes_remaining == 0) {
 			int64_t request = tar->entry_bytes_remaining +
 			    tar->entry_padding;
@@ -650,16 +665,16 @@ archive_read_format_tar_read_data(struct archive_read *a,
 			bytes_read = (ssize_t)tar->entry_bytes_remaining;
 		/* Don't read more than is available in the
 		 * current sparse block. */
-		if (tar->sparse_list->remaining < bytes_read)
-			bytes_read = (ssize_t)tar->sparse_list->remaining;
+		if (tar->sparse_cursor->remaining < bytes_read)
+			bytes_read = (ssize_t)tar->sparse_cursor->remaining;
 		*size = bytes_read;
-		*offset = tar->sparse_list->offset;
-		tar->sparse_list->remaining -= bytes_read;
-		tar->sparse_list->offset += bytes_read;
+		*offset = tar->sparse_cursor->offset;
+		tar->sparse_cursor->remaining -= bytes_read;
+		tar->sparse_cursor->offset += bytes_read;
 		tar->entry_bytes_remaining -= bytes_read;
 		tar->entry_bytes_unconsumed = bytes_read;
 
-		if (!tar->sparse_list->hole)
+		if (!tar->sparse_cursor->hole)
 			return (ARCHIVE_OK);
 		/* Current is hole data and skip this. */
 	}
@@ -687,6 +702,149 @@ archive_read_format_tar_skip(struct archive_read *a)
 	return (ARCHIVE_OK);
 }
 
+/*
+ * Jump to a header offset previously reported by
+ * archive_read_header_position().  Whatever remains of the current
+ * entry is simply abandoned, so only the per-entry body state needs
+ * resetting; the header parser rebuilds everything else.
+ *
+ * The recorded position is where the entry's header chain begins, so
+ * any pax 'x' or GNU 'L'/'K' headers in front of it are re-read here
+ * exactly as they were the first time.  Headers further back are not
+ * revisited; the only ones that could matter are pax global 'g'
+ * headers, and this reader ignores their contents in sequential reads
+ * as well, so a seek yields the same entry either way.
+ */
+static int
+archive_read_format_tar_seek_header(struct archive_read *a, int64_t offset)
+{
+	struct tar *tar = a->format->data;
+	int64_t r;
+
+	if (offset % 512 != 0) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Tar header offset %jd is not block aligned",
+		    (intmax_t)offset);
+		return (ARCHIVE_FAILED);
+	}
+
+	r = __archive_read_seek(a, offset, SEEK_SET);
+	if (r == ARCHIVE_FAILED) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Cannot seek to a header in this archive"
+		    " (input is not seekable)");
+		return (ARCHIVE_FAILED);
+	}
+	if (r < 0)
+		return (ARCHIVE_FATAL);
+
+	tar->entry_bytes_remaining = 0;
+	tar->entry_bytes_unconsumed = 0;
+	tar->entry_padding = 0;
+	gnu_clear_sparse_list(tar);
+
+	return (ARCHIVE_OK);
+}
+
+/*
+ * Reposition within the body of the current entry.  The sparse map
+ * translates the requested file offset into a position in the
+ * archive; offsets that land in a hole are positioned at the next
+ * block of data and archive_read_data() fills the gap with zeros.
+ * Seeking forward just skips, seeking backward requires a seekable
+ * input.
+ */
+static int64_t
+archive_read_format_tar_seek_data(struct archive_read *a, int64_t offset,
+    int whence)
+{
+	struct tar *tar = a->format->data;
+	struct sparse_block *sb;
+	int64_t target, clamped, stored, skip, r;
+
+	switch (whence) {
+	case SEEK_SET:
+		target = offset;
+		break;
+	case SEEK_CUR:
+		if (tar->sparse_cursor != NULL &&
+		    tar->entry_bytes_remaining > 0)
+			target = tar->sparse_cursor->offset + offset;
+		else
+			target = tar->disk_size + offset;
+		break;
+	case SEEK_END:
+		target = tar->disk_size + offset;
+		break;
+	default:
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Invalid whence value %d", whence);
+		return (ARCHIVE_FAILED);
+	}
+	if (target < 0) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Attempt to seek before the start of the entry");
+		return (ARCHIVE_FAILED);
+	}
+	clamped = target < tar->disk_size ? target : tar->disk_size;
+
+	/* Find how much stored data precedes the target offset. */
+	stored = 0;
+	skip = 0;
+	for (sb = tar->sparse_list; sb != NULL; sb = sb->next) {
+		if (clamped < sb->start + sb->size) {
+			if (clamped > sb->start)
+				skip = clamped - sb->start;
+			break;
+		}
+		stored += sb->size;
+	}
+	if (stored + skip > tar->entry_data_size) {
+		stored = tar->entry_data_size;
+		skip = 0;
+	}
+
+	/* Bytes handed out but not yet consumed are still buffered,
+	 * so a short step backward never needs to seek. */
+	r = __archive_read_reposition(a,
+	    tar->entry_data_start + stored + skip);
+	if (r == ARCHIVE_FAILED) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Cannot seek backward in this archive"
+		    " (input is not seekable)");
+		return (ARCHIVE_FAILED);
+	}
+	if (r < 0)
+		return (ARCHIVE_FATAL);
+
+	tar->entry_bytes_unconsumed = 0;
+
+	/* Blocks before the target are used up, later ones are not. */
+	tar->sparse_cursor = NULL;
+	for (sb = tar->sparse_list; sb != NULL; sb = sb->next) {
+		if (tar->sparse_cursor == NULL &&
+		    clamped < sb->start + sb->size) {
+			tar->sparse_cursor = sb;
+			sb->offset = sb->start + skip;
+			sb->remaining = sb->size - skip;
+		} else if (tar->sparse_cursor == NULL) {
+			sb->offset = sb->start + sb->size;
+			sb->remaining = 0;
+		} else {
+			sb->offset = sb->start;
+			sb->remaining = sb->size;
+		}
+	}
+	tar->entry_bytes_remaining = tar->entry_data_size - stored - skip;
+	tar->entry_padding = tar->entry_data_padding;
+
+	/* Restart archive_read_data() at the new offset. */
+	__archive_reset_read_data(&a->archive);
+	a->archive.read_data_offset = clamped;
+	a->archive.read_data_output_offset = clamped;
+	return (target);
+}
+
 /*
  * This function resets the accumulated state while reading
  * a header.
@@ -994,7 +1152,7 @@ checksum(struct archive_read *a, const void *h)
 {
 	const unsigned char *bytes;
 	const struct archive_entry_header_ustar	*header;
-	int check, sum;
+	int check, sum, high;
 	size_t i;
 
 	(void)a; /* UNUSED */
@@ -1010,16 +1168,22 @@ checksum(struct archive_read *a, const void *h)
 
 	/*
 	 * Test the checksum.  Note that POSIX specifies _unsigned_
-	 * bytes for this calculation.
+	 * bytes for this calculation.  Counting the bytes with the
+	 * high bit set in the same pass gives the _signed_ sum too,
+	 * since each of those is 256 less when read as signed.  These
+	 * simple loops are easy for compilers to vectorize.
 	 */
 	sum = (int)tar_atol(header->checksum, sizeof(header->checksum));
-	check = 0;
-	for (i = 0; i < 148; i++)
-		check += (unsigned char)bytes[i];
-	for (; i < 156; i++)
-		check += 32;
-	for (; i < 512; i++)
-		check += (unsigned char)bytes[i];
+	check = 8 * 32;
+	high = 0;
+	for (i = 0; i < 148; i++) {
+		check += bytes[i];
+		high += bytes[i] >> 7;
+	}
+	for (i = 156; i < 512; i++) {
+		check += bytes[i];
+		high += bytes[i] >> 7;
+	}
 	if (sum == check)
 		return (1);
 
@@ -1028,14 +1192,7 @@ checksum(struct archive_read *a, const void *h)
 	 * was created by an old BSD, Solaris, or HP-UX tar with a
 	 * broken checksum calculation.
 	 */
-	check = 0;
-	for (i = 0; i < 148; i++)
-		check += (signed char)bytes[i];
-	for (; i < 156; i++)
-		check += 32;
-	for (; i < 512; i++)
-		check += (signed char)bytes[i];
-	if (sum == check)
+	if (high != 0 && sum == check - 256 * high)
 		return (1);
 
 #if DONT_FAIL_ON_CRC_ERROR
@@ -1052,11 +1209,15 @@ checksum(struct archive_read *a, const void *h)
 static int
 archive_block_is_null(const char *p)
 {
+	uint64_t w;
 	unsigned i;
 
-	for (i = 0; i < 512; i++)
-		if (*p++)
+	/* Test a word at a time; memcpy() keeps this alignment-safe. */
+	for (i = 0; i < 512; i += sizeof(w)) {
+		memcpy(&w, p + i, sizeof(w));
+		if (w != 0)
 			return (0);
+	}
 	return (1);
 }
 
@@ -1433,8 +1594,10 @@ header_common(struct archive_read *a, struct tar *tar,
 	switch (tar->filetype) {
 	case '1': /* Hard link */
 		archive_entry_set_link_to_hardlink(entry);
-		existing_wcs_linkpath = archive_entry_hardlink_w(entry);
 		existing_linkpath = archive_entry_hardlink(entry);
+		existing_wcs_linkpath = NULL;
+		if (existing_linkpath == NULL || existing_linkpath[0] == '\0')
+			existing_wcs_linkpath = archive_entry_hardlink_w(entry);
 		if ((existing_linkpath == NULL || existing_linkpath[0] == '\0')
 		    && (existing_wcs_linkpath == NULL || existing_wcs_linkpath[0] == '\0')) {
 			struct archive_string linkpath;
@@ -1511,8 +1674,10 @@ header_common(struct archive_read *a, struct tar *tar,
 		break;
 	case '2': /* Symlink */
 		archive_entry_set_link_to_symlink(entry);
-		existing_wcs_linkpath = archive_entry_symlink_w(entry);
 		existing_linkpath = archive_entry_symlink(entry);
+		existing_wcs_linkpath = NULL;
+		if (existing_linkpath == NULL || existing_linkpath[0] == '\0')
+			existing_wcs_linkpath = archive_entry_symlink_w(entry);
 		if ((existing_linkpath == NULL || existing_linkpath[0] == '\0')
 		    && (existing_wcs_linkpath == NULL || existing_wcs_linkpath[0] == '\0')) {
 			struct archive_string linkpath;
@@ -1612,7 +1777,9 @@ header_old_tar(struct archive_read *a, struct tar *tar,
 	header = (const struct archive_entry_header_ustar *)h;
 
 	const char *existing_pathname = archive_entry_pathname(entry);
-	const wchar_t *existing_wcs_pathname = archive_entry_pathname_w(entry);
+	const wchar_t *existing_wcs_pathname = NULL;
+	if (existing_pathname == NULL || existing_pathname[0] == '\0')
+		existing_wcs_pathname = archive_entry_pathname_w(entry);
 	if ((existing_pathname == NULL || existing_pathname[0] == '\0')
 	    && (existing_wcs_pathname == NULL || existing_wcs_pathname[0] == '\0') &&
 	    archive_entry_copy_pathname_l(entry,
@@ -1790,7 +1957,9 @@ header_ustar(struct archive_read *a, struct tar *tar,
 	 * Use a temporary string only when prefix/name joining is required.
 	 */
 	const char *existing_pathname = archive_entry_pathname(entry);
-	const wchar_t *existing_wcs_pathname = archive_entry_pathname_w(entry);
+	const wchar_t *existing_wcs_pathname = NULL;
+	if (existing_pathname == NULL || existing_pathname[0] == '\0')
+		existing_wcs_pathname = archive_entry_pathname_w(entry);
 	if ((existing_pathname == NULL || existing_pathname[0] == '\0')
 	    && (existing_wcs_pathname == NULL || existing_wcs_pathname[0] == '\0')) {
 		struct archive_string as;
@@ -3045,7 +3214,9 @@ header_gnutar(struct archive_read *a, struct tar *tar,
 
 	/* Copy filename over (to ensure null termination). */
 	const char *existing_pathname = archive_entry_pathname(entry);
-	const wchar_t *existing_wcs_pathname = archive_entry_pathname_w(entry);
+	const wchar_t *existing_wcs_pathname = NULL;
+	if (existing_pathname == NULL || existing_pathname[0] == '\0')
+		existing_wcs_pathname = archive_entry_pathname_w(entry);
 	if ((existing_pathname == NULL || existing_pathname[0] == '\0')
 	    && (existing_wcs_pathname == NULL || existing_wcs_pathname[0] == L'\0')) {
 		if (archive_entry_copy_pathname_l(entry,
@@ -3151,8 +3322,8 @@ gnu_add_sparse_entry(struct archive_read *a, struct tar *tar,
 		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC, "Malformed sparse map data");
 		return (ARCHIVE_FATAL);
 	}
-	p->offset = offset;
-	p->remaining = remaining;
+	p->offset = p->start = offset;
+	p->remaining = p->size = remaining;
 	return (ARCHIVE_OK);
 }
 
@@ -3167,6 +3338,7 @@ gnu_clear_sparse_list(struct tar *tar)
 		free(p);
 	}
 	tar->sparse_last = NULL;
+	tar->sparse_cursor = NULL;
 }
 
 /*
@@ -3494,6 +3666,7 @@ tar_atol_base_n(const char *p, size_t char_cnt, int base)
 {
 	int64_t	l;
 	int digit, sign;
+	size_t safe;
 
 	/* the pointer will not be dereferenced if char_cnt is zero
 	 * due to the way the && operator is evaluated.
@@ -3511,6 +3684,21 @@ tar_atol_base_n(const char *p, size_t char_cnt, int base)
 	}
 
 	l = 0;
+	/*
+	 * Header fields are at most 12 octal digits, which cannot
+	 * overflow, so take the digits without the overflow checks
+	 * while that is guaranteed: 21 octal or 18 decimal digits.
+	 */
+	safe = (base == 8) ? 21 : 18;
+	while (char_cnt != 0 && safe != 0) {
+		digit = *p - '0';
+		if (digit < 0 || digit >= base)
+			return l;
+		l = l * base + sign * digit;
+		p++;
+		char_cnt--;
+		safe--;
+	}
 	while (char_cnt != 0) {
 		digit = *p - '0';
 		if (digit < 0 || digit >= base)
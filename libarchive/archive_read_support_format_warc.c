@@ -165,6 +165,7 @@ archive_read_support_format_warc(struct archive *_a)
 	    NULL,
 	    archive_read_format_warc_cleanup,
 	    NULL,
+	    NULL,
 	    NULL);
 
 	if (r != ARCHIVE_OK)
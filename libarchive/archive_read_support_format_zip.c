@@ -60,6 +60,9 @@
 #ifdef HAVE_ZSTD_H
 #include <zstd.h>
 #endif
+#ifdef HAVE_LIBDEFLATE_H
+#include <libdeflate.h>
+#endif
 
 #include "archive.h"
 #include "archive_digest_private.h"
@@ -82,10 +85,14 @@
 /* maximum length of Mac metadata in MiB */
 #define ZIP_MAX_METADATA	10U
 
+/* Largest deflated entry handed to libdeflate in one piece. */
+#define ZIP_LIBDEFLATE_MAX	(1024 * 1024)
+
 struct zip_entry {
 	struct archive_rb_node	node;
 	struct zip_entry	*next;
 	int64_t			local_header_offset;
+	int64_t			central_header_offset;
 	int64_t			compressed_size;
 	int64_t			uncompressed_size;
 	int64_t			gid;
@@ -133,6 +140,7 @@ struct trad_enc_ctx {
 /* Bits used in flags. */
 #define LA_USED_ZIP64	(1 << 0)
 #define LA_FROM_CENTRAL_DIRECTORY (1 << 1)
+#define LA_UNICODE_PATH	(1 << 2)
 
 /*
  * See "WinZip - AES Encryption Information"
@@ -156,6 +164,11 @@ struct zip {
 	struct zip_entry	*zip_entries;
 	struct archive_rb_tree	tree;
 	struct archive_rb_tree	tree_rsrc;
+	/* Walking the central directory in place instead ("central-
+	 * directory" option without Mac extensions). */
+	int64_t			central_directory_start;
+	int64_t			central_directory_correction;
+	int64_t			central_directory_cursor;
 
 	/* Bytes read but not yet consumed via __archive_read_consume() */
 	size_t			unconsumed;
@@ -173,10 +186,16 @@ struct zip {
 	unsigned long		(*crc32func)(unsigned long, const void *,
 				    size_t);
 	char			ignore_crc32;
+	/* Set when archive_seek_data() skipped part of the entry,
+	 * which leaves nothing to check the CRC32 against. */
+	char			crc32_incomplete;
 
 	/* Flags to mark progress of decompression. */
 	char			decompress_init;
 	char			end_of_entry;
+	/* Entry came from the central directory; its local file
+	 * header has not been read yet. */
+	char			local_header_pending;
 
 	unsigned char 		*uncompressed_buffer;
 	size_t 			uncompressed_buffer_size;
@@ -186,6 +205,10 @@ struct zip {
 	char			stream_valid;
 #endif
 
+#if HAVE_LIBDEFLATE_H && HAVE_LIBDEFLATE
+	struct libdeflate_decompressor *libdeflate;
+#endif
+
 #if HAVE_LZMA_H && HAVE_LIBLZMA
 	lzma_stream		zipx_lzma_stream;
 	char            zipx_lzma_valid;
@@ -203,6 +226,9 @@ struct zip {
 
 	IByteIn			zipx_ppmd_stream;
 	ssize_t			zipx_ppmd_read_compressed;
+	const uint8_t		*zipx_ppmd_in;
+	const uint8_t		*zipx_ppmd_next_in;
+	size_t			zipx_ppmd_avail_in;
 	CPpmd8			ppmd8;
 	char			ppmd8_valid;
 	char			ppmd8_stream_failed;
@@ -212,6 +238,7 @@ struct zip {
 	struct archive_string_conv *sconv_utf8;
 	int			init_default_conversion;
 	int			process_mac_extensions;
+	int			central_directory_only;
 
 	char			init_decryption;
 
@@ -281,48 +308,71 @@ static void
 trad_enc_decrypt_update(struct trad_enc_ctx *, const uint8_t *, size_t,
     uint8_t *, size_t);
 
+static int
+zip_read_pending_local_header(struct archive_read *, struct zip *);
+
+/* Release the compressed bytes that ppmd_read() has handed out since the
+ * last call, and feed them to the HMAC if the entry is authenticated. */
+static void
+ppmd_read_consume(struct archive_read *a, struct zip *zip)
+{
+	size_t used = zip->zipx_ppmd_next_in - zip->zipx_ppmd_in;
+
+	if (used > 0) {
+		if (zip->hctx_valid)
+			archive_hmac_sha1_update(&zip->hctx,
+			    zip->zipx_ppmd_in, used);
+		__archive_read_consume(a, used);
+	}
+	zip->zipx_ppmd_in = zip->zipx_ppmd_next_in = NULL;
+	zip->zipx_ppmd_avail_in = 0;
+}
+
 /* This function is used by Ppmd8_DecodeSymbol during decompression of Ppmd8
  * streams inside ZIP files. It has 2 purposes: one is to fetch the next
  * compressed byte from the stream, second one is to increase the counter how
- * many compressed bytes were read. */
+ * many compressed bytes were read. Bytes are taken from the whole read-ahead
+ * window and only consumed by ppmd_read_consume(), which the callers of the
+ * decoder run before touching the stream themselves. */
 static Byte
 ppmd_read(void* p) {
 	/* Get the handle to current decompression context. */
 	struct archive_read *a = ((IByteIn*)p)->a;
 	struct zip *zip = a->format->data;
+	uint8_t val;
 
 	/* Fetch next byte. */
-	const uint8_t* data = __archive_read_ahead(a, 1, NULL);
-	if(data == NULL) {
-		zip->ppmd8_stream_failed = 1;
-		return 0;
-	}
+	if (zip->zipx_ppmd_avail_in == 0) {
+		const uint8_t* data;
+		ssize_t bytes_avail;
 
-	if (zip->tctx_valid || zip->cctx_valid) {
-		uint8_t val;
-		if (zip->tctx_valid) {
-			trad_enc_decrypt_update(&zip->tctx,
-			    data, 1, &val, 1);
-		} else {
-			size_t dsize = 1;
-			archive_decrypto_aes_ctr_update(&zip->cctx,
-			    data, 1, &val, &dsize);
+		ppmd_read_consume(a, zip);
+		data = __archive_read_ahead(a, 1, &bytes_avail);
+		if(data == NULL) {
+			zip->ppmd8_stream_failed = 1;
+			return 0;
 		}
-		if (zip->hctx_valid)
-			archive_hmac_sha1_update(&zip->hctx, data, 1);
-
-		__archive_read_consume(a, 1);
-		++zip->zipx_ppmd_read_compressed;
-		return val;
+		zip->zipx_ppmd_in = zip->zipx_ppmd_next_in = data;
+		zip->zipx_ppmd_avail_in = bytes_avail;
 	}
+	val = *zip->zipx_ppmd_next_in;
 
-	__archive_read_consume(a, 1);
+	if (zip->tctx_valid) {
+		trad_enc_decrypt_update(&zip->tctx,
+		    zip->zipx_ppmd_next_in, 1, &val, 1);
+	} else if (zip->cctx_valid) {
+		size_t dsize = 1;
+		archive_decrypto_aes_ctr_update(&zip->cctx,
+		    zip->zipx_ppmd_next_in, 1, &val, &dsize);
+	}
+	zip->zipx_ppmd_next_in++;
+	zip->zipx_ppmd_avail_in--;
 
 	/* Increment the counter. */
 	++zip->zipx_ppmd_read_compressed;
 
 	/* Return the next compressed byte. */
-	return data[0];
+	return val;
 }
 
 /* ------------------------------------------------------------------------ */
@@ -968,6 +1018,7 @@ process_extra(struct archive_read *a, struct archive_entry *entry,
 		case 0x7075:
 		{
 			/* Info-ZIP Unicode Path Extra Field. */
+			zip_entry->flags |= LA_UNICODE_PATH;
 			if (datasize < 5 || entry == NULL)
 				break;
 			offset += 5;
@@ -1095,31 +1146,13 @@ process_extra(struct archive_read *a, struct archive_entry *entry,
 }
 
 /*
- * Assumes file pointer is at beginning of local file header.
+ * Set the pathname of an entry from a local or central file header.
  */
 static int
-zip_read_local_file_header(struct archive_read *a, struct archive_entry *entry,
-    struct zip *zip)
+zip_copy_pathname(struct archive_read *a, struct zip *zip,
+    struct archive_entry *entry, const char *h, size_t filename_length)
 {
-	const char *p;
-	const void *h;
-	const wchar_t *wp;
-	const char *cp;
-	size_t len, filename_length, extra_length;
 	struct archive_string_conv *sconv;
-	struct zip_entry *zip_entry = zip->entry;
-	struct zip_entry zip_entry_central_dir;
-	int ret = ARCHIVE_OK;
-	char version;
-
-	/* Save a copy of the original for consistency checks. */
-	zip_entry_central_dir = *zip_entry;
-
-	zip->decompress_init = 0;
-	zip->end_of_entry = 0;
-	zip->entry_uncompressed_bytes_read = 0;
-	zip->entry_compressed_bytes_read = 0;
-	zip->computed_crc32 = zip->crc32func(0, NULL, 0);
 
 	/* Setup default conversion. */
 	if (zip->sconv == NULL && !zip->init_default_conversion) {
@@ -1128,51 +1161,7 @@ zip_read_local_file_header(struct archive_read *a, struct archive_entry *entry,
 		zip->init_default_conversion = 1;
 	}
 
-	if ((p = __archive_read_ahead(a, ZIP_LOCHDR_LEN, NULL)) == NULL) {
-		archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
-		    "Truncated ZIP file header");
-		return (ARCHIVE_FATAL);
-	}
-
-	if (memcmp(p, "PK\003\004", 4) != 0) {
-		archive_set_error(&a->archive, -1, "Damaged Zip archive");
-		return ARCHIVE_FATAL;
-	}
-	version = p[4];
-	zip_entry->system = p[5];
-	zip_entry->zip_flags = archive_le16dec(p + 6);
-	if (zip_entry->zip_flags & (ZIP_ENCRYPTED | ZIP_STRONG_ENCRYPTED)) {
-		zip->has_encrypted_entries = 1;
-		archive_entry_set_is_data_encrypted(entry, 1);
-		if (zip_entry->zip_flags & ZIP_CENTRAL_DIRECTORY_ENCRYPTED &&
-			zip_entry->zip_flags & ZIP_ENCRYPTED &&
-			zip_entry->zip_flags & ZIP_STRONG_ENCRYPTED) {
-			archive_entry_set_is_metadata_encrypted(entry, 1);
-			return ARCHIVE_FATAL;
-		}
-	}
-	zip->init_decryption = (zip_entry->zip_flags & ZIP_ENCRYPTED);
-	zip_entry->compression = (char)archive_le16dec(p + 8);
-	zip_entry->mtime = dos_to_unix(archive_le32dec(p + 10));
-	zip_entry->crc32 = archive_le32dec(p + 14);
-	if (zip_entry->zip_flags & ZIP_LENGTH_AT_END)
-		zip_entry->decdat = p[11];
-	else
-		zip_entry->decdat = p[17];
-	zip_entry->compressed_size = archive_le32dec(p + 18);
-	zip_entry->uncompressed_size = archive_le32dec(p + 22);
-	filename_length = archive_le16dec(p + 26);
-	extra_length = archive_le16dec(p + 28);
-
-	__archive_read_consume(a, ZIP_LOCHDR_LEN);
-
-	/* Read the filename. */
-	if ((h = __archive_read_ahead(a, filename_length, NULL)) == NULL) {
-		archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
-		    "Truncated ZIP file header");
-		return (ARCHIVE_FATAL);
-	}
-	if (zip_entry->zip_flags & ZIP_UTF8_NAME) {
+	if (zip->entry->zip_flags & ZIP_UTF8_NAME) {
 		/* The filename is stored to be UTF-8. */
 		if (zip->sconv_utf8 == NULL) {
 			zip->sconv_utf8 =
@@ -1199,22 +1188,20 @@ zip_read_local_file_header(struct archive_read *a, struct archive_entry *entry,
 		    "Pathname cannot be converted "
 		    "from %s to current locale",
 		    archive_string_conversion_charset_name(sconv));
-		ret = ARCHIVE_WARN;
-	}
-	__archive_read_consume(a, filename_length);
-
-	/* Read the extra data. */
-	if ((h = __archive_read_ahead(a, extra_length, NULL)) == NULL) {
-		archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
-		    "Truncated ZIP file header");
-		return (ARCHIVE_FATAL);
+		return (ARCHIVE_WARN);
 	}
+	return (ARCHIVE_OK);
+}
 
-	if (ARCHIVE_OK != process_extra(a, entry, h, extra_length,
-	    zip_entry)) {
-		return ARCHIVE_FATAL;
-	}
-	__archive_read_consume(a, extra_length);
+/*
+ * Reconcile the file type with the pathname once both are known.
+ */
+static void
+zip_fixup_entry_type(struct zip_entry *zip_entry, struct archive_entry *entry)
+{
+	const wchar_t *wp;
+	const char *cp;
+	size_t len;
 
 	/* Work around a bug in Info-Zip: When reading from a pipe, it
 	 * stats the pipe instead of synthesizing a file entry. */
@@ -1297,6 +1284,97 @@ zip_read_local_file_header(struct archive_read *a, struct archive_entry *entry,
 			}
 		}
 	}
+}
+
+/*
+ * Assumes file pointer is at beginning of local file header.
+ */
+static int
+zip_read_local_file_header(struct archive_read *a, struct archive_entry *entry,
+    struct zip *zip)
+{
+	const char *p;
+	const void *h;
+	size_t filename_length, extra_length;
+	struct archive_string_conv *sconv;
+	struct zip_entry *zip_entry = zip->entry;
+	struct zip_entry zip_entry_central_dir;
+	int ret = ARCHIVE_OK;
+	char version;
+
+	/* Save a copy of the original for consistency checks. */
+	zip_entry_central_dir = *zip_entry;
+
+	zip->decompress_init = 0;
+	zip->end_of_entry = 0;
+	zip->entry_uncompressed_bytes_read = 0;
+	zip->entry_compressed_bytes_read = 0;
+	zip->computed_crc32 = zip->crc32func(0, NULL, 0);
+	zip->crc32_incomplete = 0;
+
+	if ((p = __archive_read_ahead(a, ZIP_LOCHDR_LEN, NULL)) == NULL) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
+		    "Truncated ZIP file header");
+		return (ARCHIVE_FATAL);
+	}
+
+	if (memcmp(p, "PK\003\004", 4) != 0) {
+		archive_set_error(&a->archive, -1, "Damaged Zip archive");
+		return ARCHIVE_FATAL;
+	}
+	version = p[4];
+	zip_entry->system = p[5];
+	zip_entry->zip_flags = archive_le16dec(p + 6);
+	if (zip_entry->zip_flags & (ZIP_ENCRYPTED | ZIP_STRONG_ENCRYPTED)) {
+		zip->has_encrypted_entries = 1;
+		archive_entry_set_is_data_encrypted(entry, 1);
+		if (zip_entry->zip_flags & ZIP_CENTRAL_DIRECTORY_ENCRYPTED &&
+			zip_entry->zip_flags & ZIP_ENCRYPTED &&
+			zip_entry->zip_flags & ZIP_STRONG_ENCRYPTED) {
+			archive_entry_set_is_metadata_encrypted(entry, 1);
+			return ARCHIVE_FATAL;
+		}
+	}
+	zip->init_decryption = (zip_entry->zip_flags & ZIP_ENCRYPTED);
+	zip_entry->compression = (char)archive_le16dec(p + 8);
+	zip_entry->mtime = dos_to_unix(archive_le32dec(p + 10));
+	zip_entry->crc32 = archive_le32dec(p + 14);
+	if (zip_entry->zip_flags & ZIP_LENGTH_AT_END)
+		zip_entry->decdat = p[11];
+	else
+		zip_entry->decdat = p[17];
+	zip_entry->compressed_size = archive_le32dec(p + 18);
+	zip_entry->uncompressed_size = archive_le32dec(p + 22);
+	filename_length = archive_le16dec(p + 26);
+	extra_length = archive_le16dec(p + 28);
+
+	__archive_read_consume(a, ZIP_LOCHDR_LEN);
+
+	/* Read the filename. */
+	if ((h = __archive_read_ahead(a, filename_length, NULL)) == NULL) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
+		    "Truncated ZIP file header");
+		return (ARCHIVE_FATAL);
+	}
+	ret = zip_copy_pathname(a, zip, entry, h, filename_length);
+	if (ret < ARCHIVE_WARN)
+		return (ret);
+	__archive_read_consume(a, filename_length);
+
+	/* Read the extra data. */
+	if ((h = __archive_read_ahead(a, extra_length, NULL)) == NULL) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
+		    "Truncated ZIP file header");
+		return (ARCHIVE_FATAL);
+	}
+
+	if (ARCHIVE_OK != process_extra(a, entry, h, extra_length,
+	    zip_entry)) {
+		return ARCHIVE_FATAL;
+	}
+	__archive_read_consume(a, extra_length);
+
+	zip_fixup_entry_type(zip_entry, entry);
 
 	if (zip_entry->flags & LA_FROM_CENTRAL_DIRECTORY) {
 		/* If this came from the central dir, its size info
@@ -2409,6 +2487,8 @@ zipx_ppmd8_init(struct archive_read *a, struct zip *zip)
 
 	/* Reset number of read bytes to 0. */
 	zip->zipx_ppmd_read_compressed = 0;
+	zip->zipx_ppmd_in = zip->zipx_ppmd_next_in = NULL;
+	zip->zipx_ppmd_avail_in = 0;
 
 	/* Read Ppmd8 header (2 bytes). */
 	if (zip->tctx_valid || zip->cctx_valid) {
@@ -2461,6 +2541,7 @@ zipx_ppmd8_init(struct archive_read *a, struct zip *zip)
 		    "PPMd8 stream range decoder initialization error");
 		return (ARCHIVE_FATAL);
 	}
+	ppmd_read_consume(a, zip);
 
 	__archive_ppmd8_functions.Ppmd8_Init(&zip->ppmd8, order,
 	    restore_method);
@@ -2540,6 +2621,7 @@ zip_read_data_zipx_ppmd(struct archive_read *a, const void **buff,
 		zip->uncompressed_buffer[consumed_bytes] = (uint8_t) sym;
 		++consumed_bytes;
 	} while(consumed_bytes < zip->uncompressed_buffer_size);
+	ppmd_read_consume(a, zip);
 
 	/* Update pointers so we can continue decompression in another call. */
 	zip->entry_bytes_remaining -= zip->zipx_ppmd_read_compressed;
@@ -2881,6 +2963,91 @@ zip_deflate_init(struct archive_read *a, struct zip *zip)
 	return (ARCHIVE_OK);
 }
 
+#if HAVE_LIBDEFLATE_H && HAVE_LIBDEFLATE
+/*
+ * libdeflate inflates much faster than zlib but cannot stream, so it
+ * is only used for entries whose sizes are known and small enough to
+ * hold in memory at once.  Returns ARCHIVE_WARN, having consumed
+ * nothing, if zlib has to handle the entry instead.
+ */
+static int
+zip_read_data_libdeflate(struct archive_read *a, const void **buff,
+    size_t *size)
+{
+	struct zip *zip = a->format->data;
+	const void *compressed_buff;
+	ssize_t bytes_avail;
+	size_t in_size, out_size, in_used, out_used;
+	enum libdeflate_result r;
+
+	if (zip->decompress_init
+	    || (zip->entry->zip_flags & ZIP_LENGTH_AT_END)
+	    || zip->tctx_valid || zip->cctx_valid
+	    || zip->entry_bytes_remaining <= 0
+	    || zip->entry_bytes_remaining > ZIP_LIBDEFLATE_MAX
+	    || zip->entry->uncompressed_size <= 0
+	    || zip->entry->uncompressed_size > ZIP_LIBDEFLATE_MAX)
+		return (ARCHIVE_WARN);
+	in_size = (size_t)zip->entry_bytes_remaining;
+	out_size = (size_t)zip->entry->uncompressed_size;
+
+	/* Truncated entries are left to zlib to report. */
+	compressed_buff = __archive_read_ahead(a, in_size, &bytes_avail);
+	if (compressed_buff == NULL)
+		return (ARCHIVE_WARN);
+
+	if (zip->libdeflate == NULL) {
+		zip->libdeflate = libdeflate_alloc_decompressor();
+		if (zip->libdeflate == NULL) {
+			archive_set_error(&a->archive, ENOMEM,
+			    "No memory for ZIP decompression");
+			return (ARCHIVE_FATAL);
+		}
+	}
+	/* Never shrink below what zip_read_data_deflate() would
+	 * allocate, since it reuses this buffer. */
+	if (zip->uncompressed_buffer == NULL ||
+	    zip->uncompressed_buffer_size < out_size) {
+		free(zip->uncompressed_buffer);
+		zip->uncompressed_buffer_size = 256 * 1024;
+		if (zip->uncompressed_buffer_size < out_size)
+			zip->uncompressed_buffer_size = out_size;
+		zip->uncompressed_buffer =
+		    malloc(zip->uncompressed_buffer_size);
+		if (zip->uncompressed_buffer == NULL) {
+			archive_set_error(&a->archive, ENOMEM,
+			    "No memory for ZIP decompression");
+			return (ARCHIVE_FATAL);
+		}
+	}
+
+	r = libdeflate_deflate_decompress_ex(zip->libdeflate,
+	    compressed_buff, in_size, zip->uncompressed_buffer, out_size,
+	    &in_used, &out_used);
+	switch (r) {
+	case LIBDEFLATE_SUCCESS:
+		break;
+	case LIBDEFLATE_INSUFFICIENT_SPACE:
+		/* The recorded size is too small; stream it instead. */
+		return (ARCHIVE_WARN);
+	default:
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "ZIP decompression failed (libdeflate %d)", (int)r);
+		return (ARCHIVE_FATAL);
+	}
+
+	__archive_read_consume(a, in_used);
+	zip->entry_bytes_remaining -= in_used;
+	zip->entry_compressed_bytes_read += in_used;
+	zip->entry_uncompressed_bytes_read += out_used;
+	zip->end_of_entry = 1;
+
+	*size = out_used;
+	*buff = zip->uncompressed_buffer;
+	return (ARCHIVE_OK);
+}
+#endif
+
 static int
 zip_read_data_deflate(struct archive_read *a, const void **buff,
     size_t *size, int64_t *offset)
@@ -2893,6 +3060,12 @@ zip_read_data_deflate(struct archive_read *a, const void **buff,
 
 	(void)offset; /* UNUSED */
 
+#if HAVE_LIBDEFLATE_H && HAVE_LIBDEFLATE
+	r = zip_read_data_libdeflate(a, buff, size);
+	if (r != ARCHIVE_WARN)
+		return (r);
+#endif
+
 	/* If the buffer hasn't been allocated, allocate it now. */
 	if (zip->uncompressed_buffer == NULL) {
 		zip->uncompressed_buffer_size = 256 * 1024;
@@ -3372,6 +3545,12 @@ archive_read_format_zip_read_data(struct archive_read *a,
 		zip->has_encrypted_entries = 0;
 	}
 
+	if (zip->local_header_pending) {
+		r = zip_read_pending_local_header(a, zip);
+		if (r != ARCHIVE_OK)
+			return (r);
+	}
+
 	*offset = zip->entry_uncompressed_bytes_read;
 	*size = 0;
 	*buff = NULL;
@@ -3475,7 +3654,7 @@ archive_read_format_zip_read_data(struct archive_read *a,
 		if ((!zip->hctx_valid ||
 		      zip->entry->aes_extra.vendor != AES_VENDOR_AE_2) &&
 		   zip->entry->crc32 != zip->computed_crc32
-		    && !zip->ignore_crc32) {
+		    && !zip->ignore_crc32 && !zip->crc32_incomplete) {
 			archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
 			    "ZIP bad CRC: 0x%lx should be 0x%lx",
 			    (unsigned long)zip->computed_crc32,
@@ -3506,6 +3685,81 @@ archive_read_format_zip_read_data(struct archive_read *a,
 	return (ARCHIVE_OK);
 }
 
+/*
+ * Only stored, unencrypted entries whose size is in the local header
+ * map offsets directly onto the archive; compressed entries would
+ * have to be decompressed again from the start.
+ */
+static int64_t
+archive_read_format_zip_seek_data(struct archive_read *a, int64_t offset,
+    int whence)
+{
+	struct zip *zip = a->format->data;
+	int64_t size, target, clamped, data_start, r;
+
+	if (zip->local_header_pending) {
+		r = zip_read_pending_local_header(a, zip);
+		if (r != ARCHIVE_OK)
+			return (r);
+	}
+	if (zip->entry->compression != 0 ||
+	    (zip->entry->zip_flags & (ZIP_ENCRYPTED | ZIP_LENGTH_AT_END))) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Seeking is only supported for stored ZIP entries"
+		    " of known size");
+		return (ARCHIVE_FAILED);
+	}
+	size = zip->entry->compressed_size;
+
+	switch (whence) {
+	case SEEK_SET:
+		target = offset;
+		break;
+	case SEEK_CUR:
+		target = zip->entry_uncompressed_bytes_read + offset;
+		break;
+	case SEEK_END:
+		target = size + offset;
+		break;
+	default:
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Invalid whence value %d", whence);
+		return (ARCHIVE_FAILED);
+	}
+	if (target < 0) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Attempt to seek before the start of the entry");
+		return (ARCHIVE_FAILED);
+	}
+	clamped = target < size ? target : size;
+
+	data_start = a->filter->position + zip->unconsumed
+	    - zip->entry_compressed_bytes_read;
+	r = __archive_read_reposition(a, data_start + clamped);
+	if (r == ARCHIVE_FAILED) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_MISC,
+		    "Cannot seek backward in this archive"
+		    " (input is not seekable)");
+		return (ARCHIVE_FAILED);
+	}
+	if (r < 0)
+		return (ARCHIVE_FATAL);
+
+	zip->unconsumed = 0;
+	zip->entry_bytes_remaining = size - clamped;
+	zip->entry_compressed_bytes_read = clamped;
+	zip->entry_uncompressed_bytes_read = clamped;
+	zip->end_of_entry = 0;
+	zip->computed_crc32 = zip->crc32func(0, NULL, 0);
+	zip->crc32_incomplete = (clamped != 0);
+
+	/* Restart archive_read_data() at the new offset. */
+	__archive_reset_read_data(&a->archive);
+	a->archive.read_data_offset = clamped;
+	a->archive.read_data_output_offset = clamped;
+	return (target);
+}
+
 static int
 archive_read_format_zip_cleanup(struct archive_read *a)
 {
@@ -3535,6 +3789,11 @@ archive_read_format_zip_cleanup(struct archive_read *a)
 	}
 #endif
 
+#if HAVE_LIBDEFLATE_H && HAVE_LIBDEFLATE
+	if (zip->libdeflate != NULL)
+		libdeflate_free_decompressor(zip->libdeflate);
+#endif
+
 	free(zip->uncompressed_buffer);
 
 	if (zip->ppmd8_valid)
@@ -3615,6 +3874,9 @@ archive_read_format_zip_options(struct archive_read *a,
 	} else if (strcmp(key, "mac-ext") == 0) {
 		zip->process_mac_extensions = (val != NULL && val[0] != 0);
 		return (ARCHIVE_OK);
+	} else if (strcmp(key, "central-directory") == 0) {
+		zip->central_directory_only = (val != NULL && val[0] != 0);
+		return (ARCHIVE_OK);
 	}
 
 	/* Note: The "warn" return is just to inform the options
@@ -3901,10 +4163,11 @@ archive_read_support_format_zip_streamable(struct archive *_a)
 	    archive_read_format_zip_streamable_read_header,
 	    archive_read_format_zip_read_data,
 	    archive_read_format_zip_read_data_skip_streamable,
-	    NULL,
+	    archive_read_format_zip_seek_data,
 	    archive_read_format_zip_cleanup,
 	    archive_read_support_format_zip_capabilities_streamable,
-	    archive_read_format_zip_has_encrypted_entries);
+	    archive_read_format_zip_has_encrypted_entries,
+	    NULL);
 
 	if (r != ARCHIVE_OK)
 		free(zip);
@@ -4166,26 +4429,25 @@ expose_parent_dirs(struct zip *zip, const char *name, size_t name_length)
 	archive_string_free(&str);
 }
 
+/*
+ * Find the start of the central directory.  The end-of-CD
+ * record has our starting point, but there are lots of
+ * Zip archives which have had other data prepended to the
+ * file, which makes the recorded offsets all too small.
+ * So we search forward from the specified offset until we
+ * find the real start of the central directory.  Then we
+ * know the correction we need to apply to account for leading
+ * padding.
+ */
 static int
-slurp_central_directory(struct archive_read *a, struct archive_entry* entry,
-    struct zip *zip)
+zip_find_central_directory(struct archive_read *a, struct zip *zip,
+    int64_t *correction)
 {
 	ssize_t i;
 	unsigned found;
-	int64_t correction;
 	ssize_t bytes_avail;
 	const char *p;
 
-	/*
-	 * Find the start of the central directory.  The end-of-CD
-	 * record has our starting point, but there are lots of
-	 * Zip archives which have had other data prepended to the
-	 * file, which makes the recorded offsets all too small.
-	 * So we search forward from the specified offset until we
-	 * find the real start of the central directory.  Then we
-	 * know the correction we need to apply to account for leading
-	 * padding.
-	 */
 	if (__archive_read_seek(a, zip->central_directory_offset_adjusted, SEEK_SET)
 		< 0)
 		return ARCHIVE_FATAL;
@@ -4222,31 +4484,132 @@ slurp_central_directory(struct archive_read *a, struct archive_entry* entry,
 		}
 		__archive_read_consume(a, i);
 	}
-	correction = archive_filter_bytes(&a->archive, 0)
+	*correction = archive_filter_bytes(&a->archive, 0)
 			- zip->central_directory_offset;
+	return ARCHIVE_OK;
+}
+
+/*
+ * Decode the central directory record at the current position into
+ * |zip_entry| without consuming it.  Returns ARCHIVE_EOF at the end
+ * of the directory; otherwise |name| points at the file name and
+ * |record_length| is the size of the whole record.
+ */
+static int
+zip_read_central_directory_record(struct archive_read *a,
+    struct zip_entry *zip_entry, int64_t correction, const char **name, size_t *name_length,
+    size_t *record_length)
+{
+	struct zip *zip = a->format->data;
+	size_t filename_length, extra_length, comment_length;
+	uint32_t external_attributes;
+	const char *p;
+
+	if ((p = __archive_read_ahead(a, 4, NULL)) == NULL)
+		return ARCHIVE_FATAL;
+	if (memcmp(p, "PK\006\006", 4) == 0
+	    || memcmp(p, "PK\005\006", 4) == 0) {
+		return ARCHIVE_EOF;
+	} else if (memcmp(p, "PK\001\002", 4) != 0) {
+		archive_set_error(&a->archive,
+		    -1, "Invalid central directory signature");
+		return ARCHIVE_FATAL;
+	}
+	if ((p = __archive_read_ahead(a, 46, NULL)) == NULL)
+		return ARCHIVE_FATAL;
+
+	zip_entry->flags |= LA_FROM_CENTRAL_DIRECTORY;
+	zip_entry->central_header_offset =
+	    archive_filter_bytes(&a->archive, 0);
+
+	/* version = p[4]; */
+	zip_entry->system = p[5];
+	/* version_required = archive_le16dec(p + 6); */
+	zip_entry->zip_flags = archive_le16dec(p + 8);
+	if (zip_entry->zip_flags
+	      & (ZIP_ENCRYPTED | ZIP_STRONG_ENCRYPTED)){
+		zip->has_encrypted_entries = 1;
+	}
+	zip_entry->compression = (char)archive_le16dec(p + 10);
+	zip_entry->mtime = dos_to_unix(archive_le32dec(p + 12));
+	zip_entry->crc32 = archive_le32dec(p + 16);
+	if (zip_entry->zip_flags & ZIP_LENGTH_AT_END)
+		zip_entry->decdat = p[13];
+	else
+		zip_entry->decdat = p[19];
+	zip_entry->compressed_size = archive_le32dec(p + 20);
+	zip_entry->uncompressed_size = archive_le32dec(p + 24);
+	filename_length = archive_le16dec(p + 28);
+	extra_length = archive_le16dec(p + 30);
+	comment_length = archive_le16dec(p + 32);
+	/* disk_start = archive_le16dec(p + 34);
+	 *   Better be zero.
+	 * internal_attributes = archive_le16dec(p + 36);
+	 *   text bit */
+	external_attributes = archive_le32dec(p + 38);
+	zip_entry->local_header_offset =
+	    archive_le32dec(p + 42) + correction;
+
+	/* If we can't guess the mode, leave it zero here;
+	   when we read the local file header we might get
+	   more information. */
+	if (zip_entry->system == 3) {
+		zip_entry->mode = external_attributes >> 16;
+	} else if (zip_entry->system == 0) {
+		// Interpret MSDOS directory bit
+		if (0x10 == (external_attributes & 0x10)) {
+			zip_entry->mode = AE_IFDIR | 0775;
+		} else {
+			zip_entry->mode = AE_IFREG | 0664;
+		}
+		if (0x01 == (external_attributes & 0x01)) {
+			// Read-only bit; strip write permissions
+			zip_entry->mode &= 0555;
+		}
+	} else {
+		zip_entry->mode = 0;
+	}
+
+	/* We're done with the regular data; get the filename and
+	 * extra data. */
+	p = __archive_read_ahead(a, 46 + filename_length + extra_length,
+		NULL);
+	if (p == NULL) {
+		archive_set_error(&a->archive,
+		    ARCHIVE_ERRNO_FILE_FORMAT,
+		    "Truncated ZIP file header");
+		return ARCHIVE_FATAL;
+	}
+	/* The entry has no name yet, so a Unicode path field cannot be
+	 * checked against one; the local file header supplies it. */
+	if (ARCHIVE_OK != process_extra(a, NULL,
+	    p + 46 + filename_length, extra_length, zip_entry)) {
+		return ARCHIVE_FATAL;
+	}
+
+	*name = p + 46;
+	*name_length = filename_length;
+	*record_length = 46 + filename_length + extra_length + comment_length;
+	return ARCHIVE_OK;
+}
+
+static int
+slurp_central_directory(struct archive_read *a, struct zip *zip)
+{
+	int64_t correction;
+	int ret;
+
+	if (zip_find_central_directory(a, zip, &correction) != ARCHIVE_OK)
+		return ARCHIVE_FATAL;
 
 	__archive_rb_tree_init(&zip->tree, &rb_ops);
 	__archive_rb_tree_init(&zip->tree_rsrc, &rb_rsrc_ops);
 
 	while (1) {
 		struct zip_entry *zip_entry;
-		size_t filename_length, extra_length, comment_length;
-		uint32_t external_attributes;
+		size_t filename_length, record_length;
 		const char *name, *r;
 
-		if ((p = __archive_read_ahead(a, 4, NULL)) == NULL)
-			return ARCHIVE_FATAL;
-		if (memcmp(p, "PK\006\006", 4) == 0
-		    || memcmp(p, "PK\005\006", 4) == 0) {
-			break;
-		} else if (memcmp(p, "PK\001\002", 4) != 0) {
-			archive_set_error(&a->archive,
-			    -1, "Invalid central directory signature");
-			return ARCHIVE_FATAL;
-		}
-		if ((p = __archive_read_ahead(a, 46, NULL)) == NULL)
-			return ARCHIVE_FATAL;
-
 		zip_entry = calloc(1, sizeof(struct zip_entry));
 		if (zip_entry == NULL) {
 			archive_set_error(&a->archive, ENOMEM,
@@ -4254,72 +4617,17 @@ slurp_central_directory(struct archive_read *a, struct archive_entry* entry,
 			return ARCHIVE_FATAL;
 		}
 		zip_entry->next = zip->zip_entries;
-		zip_entry->flags |= LA_FROM_CENTRAL_DIRECTORY;
 		zip->zip_entries = zip_entry;
 
-		/* version = p[4]; */
-		zip_entry->system = p[5];
-		/* version_required = archive_le16dec(p + 6); */
-		zip_entry->zip_flags = archive_le16dec(p + 8);
-		if (zip_entry->zip_flags
-		      & (ZIP_ENCRYPTED | ZIP_STRONG_ENCRYPTED)){
-			zip->has_encrypted_entries = 1;
-		}
-		zip_entry->compression = (char)archive_le16dec(p + 10);
-		zip_entry->mtime = dos_to_unix(archive_le32dec(p + 12));
-		zip_entry->crc32 = archive_le32dec(p + 16);
-		if (zip_entry->zip_flags & ZIP_LENGTH_AT_END)
-			zip_entry->decdat = p[13];
-		else
-			zip_entry->decdat = p[19];
-		zip_entry->compressed_size = archive_le32dec(p + 20);
-		zip_entry->uncompressed_size = archive_le32dec(p + 24);
-		filename_length = archive_le16dec(p + 28);
-		extra_length = archive_le16dec(p + 30);
-		comment_length = archive_le16dec(p + 32);
-		/* disk_start = archive_le16dec(p + 34);
-		 *   Better be zero.
-		 * internal_attributes = archive_le16dec(p + 36);
-		 *   text bit */
-		external_attributes = archive_le32dec(p + 38);
-		zip_entry->local_header_offset =
-		    archive_le32dec(p + 42) + correction;
-
-		/* If we can't guess the mode, leave it zero here;
-		   when we read the local file header we might get
-		   more information. */
-		if (zip_entry->system == 3) {
-			zip_entry->mode = external_attributes >> 16;
-		} else if (zip_entry->system == 0) {
-			// Interpret MSDOS directory bit
-			if (0x10 == (external_attributes & 0x10)) {
-				zip_entry->mode = AE_IFDIR | 0775;
-			} else {
-				zip_entry->mode = AE_IFREG | 0664;
-			}
-			if (0x01 == (external_attributes & 0x01)) {
-				// Read-only bit; strip write permissions
-				zip_entry->mode &= 0555;
-			}
-		} else {
-			zip_entry->mode = 0;
-		}
-
-		/* We're done with the regular data; get the filename and
-		 * extra data. */
-		__archive_read_consume(a, 46);
-		p = __archive_read_ahead(a, filename_length + extra_length,
-			NULL);
-		if (p == NULL) {
-			archive_set_error(&a->archive,
-			    ARCHIVE_ERRNO_FILE_FORMAT,
-			    "Truncated ZIP file header");
-			return ARCHIVE_FATAL;
-		}
-		if (ARCHIVE_OK != process_extra(a, entry, p + filename_length,
-		    extra_length, zip_entry)) {
-			return ARCHIVE_FATAL;
+		ret = zip_read_central_directory_record(a, zip_entry,
+		    correction, &name, &filename_length, &record_length);
+		if (ret == ARCHIVE_EOF) {
+			zip->zip_entries = zip_entry->next;
+			free(zip_entry);
+			break;
 		}
+		if (ret != ARCHIVE_OK)
+			return ret;
 
 		/*
 		 * Mac resource fork files are stored under the
@@ -4331,7 +4639,6 @@ slurp_central_directory(struct archive_read *a, struct archive_entry* entry,
 			__archive_rb_tree_insert_node(&zip->tree,
 			    &zip_entry->node);
 		} else {
-			name = p;
 			r = rsrc_basename(name, filename_length);
 			if (filename_length >= 9 &&
 			    strncmp("__MACOSX/", name, 9) == 0) {
@@ -4386,8 +4693,7 @@ slurp_central_directory(struct archive_read *a, struct archive_entry* entry,
 		}
 
 		/* Skip the comment too ... */
-		__archive_read_consume(a,
-		    filename_length + extra_length + comment_length);
+		__archive_read_consume(a, record_length);
 	}
 
 	return ARCHIVE_OK;
@@ -4567,6 +4873,175 @@ exit_mac_metadata:
 	return (ret);
 }
 
+/*
+ * Move to |offset|, skipping forward where possible since entries
+ * are visited in file order.
+ */
+static int
+zip_seekable_position(struct archive_read *a, int64_t offset)
+{
+	int64_t here = archive_filter_bytes(&a->archive, 0);
+
+	if (here < offset)
+		return (__archive_read_consume(a, offset - here) < 0 ?
+		    ARCHIVE_FATAL : ARCHIVE_OK);
+	if (here != offset &&
+	    __archive_read_seek(a, offset, SEEK_SET) < 0)
+		return (ARCHIVE_FATAL);
+	return (ARCHIVE_OK);
+}
+
+/*
+ * Fill in an entry from its central directory record alone, for the
+ * "central-directory" option.  Sizes, mode, times and flags were
+ * already decoded by slurp_central_directory(), so only the name has
+ * to be read back.  The local file header is read when the entry's
+ * data is first requested.
+ */
+static int
+zip_read_central_file_header(struct archive_read *a,
+    struct archive_entry *entry, struct zip *zip)
+{
+	struct zip_entry *zip_entry = zip->entry;
+	const char *p;
+	size_t filename_length;
+	int ret;
+	char version;
+
+	if (zip_seekable_position(a, zip_entry->central_header_offset)
+	    != ARCHIVE_OK)
+		return (ARCHIVE_FATAL);
+	zip->unconsumed = 0;
+	if ((p = __archive_read_ahead(a, 46, NULL)) == NULL) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
+		    "Truncated ZIP file header");
+		return (ARCHIVE_FATAL);
+	}
+	version = p[6];
+	filename_length = archive_le16dec(p + 28);
+	if ((p = __archive_read_ahead(a, 46 + filename_length, NULL))
+	    == NULL) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
+		    "Truncated ZIP file header");
+		return (ARCHIVE_FATAL);
+	}
+	ret = zip_copy_pathname(a, zip, entry, p + 46, filename_length);
+	if (ret < ARCHIVE_WARN)
+		return (ret);
+
+	if ((zip_entry->mode & AE_IFMT) == AE_IFIFO) {
+		zip_entry->mode &= ~AE_IFMT;
+		zip_entry->mode |= AE_IFREG;
+	}
+	if (zip_entry->mode == 0)
+		zip_entry->mode |= 0664;
+	zip_fixup_entry_type(zip_entry, entry);
+
+	if (zip_entry->zip_flags & (ZIP_ENCRYPTED | ZIP_STRONG_ENCRYPTED))
+		archive_entry_set_is_data_encrypted(entry, 1);
+	archive_entry_set_mode(entry, zip_entry->mode);
+	archive_entry_set_uid(entry, zip_entry->uid);
+	archive_entry_set_gid(entry, zip_entry->gid);
+	archive_entry_set_mtime(entry, zip_entry->mtime, 0);
+	archive_entry_set_ctime(entry, zip_entry->ctime, 0);
+	archive_entry_set_atime(entry, zip_entry->atime, 0);
+	archive_entry_set_size(entry, zip_entry->uncompressed_size);
+
+	archive_string_empty(&zip->format_name);
+	archive_string_sprintf(&zip->format_name, "ZIP %d.%d (%s)",
+	    version / 10, version % 10,
+	    compression_name(zip_entry->compression));
+	a->archive.archive_format_name = zip->format_name.s;
+
+	zip->local_header_pending = 1;
+	return (ret);
+}
+
+/*
+ * Read the local file header that zip_read_central_file_header()
+ * put off.  The caller already has its entry, so the header is
+ * decoded into a scratch one.
+ */
+static int
+zip_read_pending_local_header(struct archive_read *a, struct zip *zip)
+{
+	struct archive_entry *scratch;
+	int r;
+
+	zip->local_header_pending = 0;
+	if (zip_seekable_position(a, zip->entry->local_header_offset)
+	    != ARCHIVE_OK)
+		return (ARCHIVE_FATAL);
+	zip->unconsumed = 0;
+	scratch = archive_entry_new2(&a->archive);
+	if (scratch == NULL) {
+		archive_set_error(&a->archive, ENOMEM, "Out of memory");
+		return (ARCHIVE_FATAL);
+	}
+	r = zip_read_local_file_header(a, scratch, zip);
+	archive_entry_free(scratch);
+	/* Inconsistencies were already reported by the header, if
+	 * at all; only give up on real errors. */
+	return (r < ARCHIVE_WARN ? r : ARCHIVE_OK);
+}
+
+/*
+ * Step to the next central directory record without loading the
+ * whole directory.  A single zip_entry is reused for every record,
+ * so memory stays flat however many entries there are, and the
+ * first header is returned without reading the rest of the
+ * directory.  Entries come back in directory order.
+ */
+static int
+zip_next_central_directory_entry(struct archive_read *a, struct zip *zip)
+{
+	struct zip_entry *zip_entry = zip->zip_entries;
+	const char *name;
+	size_t name_length, record_length;
+	int r;
+
+	zip->unconsumed = 0;
+	if (zip_entry == NULL) {
+		zip_entry = calloc(1, sizeof(struct zip_entry));
+		if (zip_entry == NULL) {
+			archive_set_error(&a->archive, ENOMEM,
+			    "Can't allocate zip entry");
+			return (ARCHIVE_FATAL);
+		}
+		zip->zip_entries = zip_entry;
+		if (zip_find_central_directory(a, zip,
+		    &zip->central_directory_correction) != ARCHIVE_OK)
+			return (ARCHIVE_FATAL);
+		zip->central_directory_start =
+		    archive_filter_bytes(&a->archive, 0);
+		zip->central_directory_cursor = zip->central_directory_start;
+	} else {
+		memset(zip_entry, 0, sizeof(*zip_entry));
+		if (zip_seekable_position(a, zip->central_directory_cursor)
+		    != ARCHIVE_OK)
+			return (ARCHIVE_FATAL);
+	}
+	zip->entry = zip_entry;
+
+	r = zip_read_central_directory_record(a, zip_entry,
+	    zip->central_directory_correction, &name, &name_length,
+	    &record_length);
+	if (r != ARCHIVE_OK)
+		return (r);
+	/* Nothing sorted the entries, so check here that the local
+	 * header lies before the directory. */
+	if (zip_entry->local_header_offset < 0 ||
+	    zip_entry->local_header_offset + ZIP_LOCHDR_LEN >
+	    zip->central_directory_start) {
+		archive_set_error(&a->archive, ARCHIVE_ERRNO_FILE_FORMAT,
+		    "Invalid local header offset in central directory");
+		return (ARCHIVE_FATAL);
+	}
+	zip->central_directory_cursor =
+	    zip_entry->central_header_offset + record_length;
+	return (ARCHIVE_OK);
+}
+
 static int
 archive_read_format_zip_seekable_read_header(struct archive_read *a,
 	struct archive_entry *entry)
@@ -4591,8 +5066,12 @@ archive_read_format_zip_seekable_read_header(struct archive_read *a,
 	if (a->archive.archive_format_name == NULL)
 		a->archive.archive_format_name = "ZIP";
 
-	if (zip->zip_entries == NULL) {
-		r = slurp_central_directory(a, entry, zip);
+	if (zip->central_directory_only && !zip->process_mac_extensions) {
+		r = zip_next_central_directory_entry(a, zip);
+		if (r != ARCHIVE_OK)
+			return r;
+	} else if (zip->zip_entries == NULL) {
+		r = slurp_central_directory(a, zip);
 		if (r != ARCHIVE_OK)
 			return r;
 		/* Get first entry whose local header offset is lower than
@@ -4621,6 +5100,17 @@ archive_read_format_zip_seekable_read_header(struct archive_read *a,
 	zip->tctx_valid = zip->cctx_valid = zip->hctx_valid = 0;
 	__archive_read_reset_passphrase(a);
 
+	/* Symlink targets and Mac metadata live in the entry bodies,
+	 * so those entries always need their local headers.  So do
+	 * entries with a Unicode path: the name is taken from the local
+	 * header's copy of that field, which need not agree with the
+	 * central directory's. */
+	zip->local_header_pending = 0;
+	if (zip->central_directory_only && rsrc == NULL &&
+	    (zip->entry->mode & AE_IFMT) != AE_IFLNK &&
+	    (zip->entry->flags & LA_UNICODE_PATH) == 0)
+		return (zip_read_central_file_header(a, entry, zip));
+
 	/* File entries are sorted by the header offset, we should mostly
 	 * use __archive_read_consume to advance a read point to avoid
 	 * redundant data reading.  */
@@ -4694,10 +5184,11 @@ archive_read_support_format_zip_seekable(struct archive *_a)
 	    archive_read_format_zip_seekable_read_header,
 	    archive_read_format_zip_read_data,
 	    archive_read_format_zip_read_data_skip_seekable,
-	    NULL,
+	    archive_read_format_zip_seek_data,
 	    archive_read_format_zip_cleanup,
 	    archive_read_support_format_zip_capabilities_seekable,
-	    archive_read_format_zip_has_encrypted_entries);
+	    archive_read_format_zip_has_encrypted_entries,
+	    NULL);
 
 	if (r != ARCHIVE_OK)
 		free(zip);
@@ -2718,6 +2718,87 @@ unicode_to_utf16le(char *p, size_t remaining, uint32_t uc)
 	}
 }
 
+/*
+ * ASCII fast paths.
+ *
+ * Most names in real archives are plain ASCII, and an ASCII character
+ * is the same code point in UTF-8 and UTF-16 and never needs
+ * canonicalizing.  The converters below find runs of such characters
+ * and copy them in bulk instead of decoding and re-encoding one code
+ * point at a time.
+ *
+ * 'isz' is the width in bytes of a source character (1 for UTF-8,
+ * 2 for UTF-16) and 'ioff' is the offset of the low byte within it
+ * (1 for UTF-16BE, 0 otherwise).  NUL is never part of a run.
+ */
+#define ASCII_WORD_HIGH_BITS	(((uint64_t)0x80808080U << 32) | 0x80808080U)
+#define ASCII_WORD_LOW_BITS	(((uint64_t)0x01010101U << 32) | 0x01010101U)
+
+static size_t
+ascii_run_len(const char *_s, size_t n, int isz, int ioff)
+{
+	const unsigned char *s = (const unsigned char *)_s;
+	size_t i = 0;
+
+	if (isz == 1) {
+		/* Check eight bytes at a time for a high bit or a NUL. */
+		while (n - i >= 8) {
+			uint64_t w;
+
+			memcpy(&w, s + i, sizeof(w));
+			if ((w & ASCII_WORD_HIGH_BITS) != 0 ||
+			    ((w - ASCII_WORD_LOW_BITS) & ~w &
+			     ASCII_WORD_HIGH_BITS) != 0)
+				break;
+			i += 8;
+		}
+		while (i < n && s[i] != 0 && s[i] < 0x80)
+			i++;
+		return (i);
+	}
+	n /= 2;
+	while (i < n && s[i * 2 + (1 - ioff)] == 0 &&
+	    s[i * 2 + ioff] != 0 && s[i * 2 + ioff] < 0x80)
+		i++;
+	return (i);
+}
+
+/*
+ * Copy 'cnt' ASCII characters found by ascii_run_len() to 'p' in the
+ * form produced by 'unparse'.  Returns the number of bytes written.
+ */
+static size_t
+ascii_run_copy(char *p, const char *s, size_t cnt, int isz, int ioff,
+    size_t (*unparse)(char *, size_t, uint32_t))
+{
+	size_t i;
+
+	if (unparse == unicode_to_utf8) {
+		if (isz == 1) {
+			memcpy(p, s, cnt);
+			return (cnt);
+		}
+		for (i = 0; i < cnt; i++)
+			p[i] = s[i * 2 + ioff];
+		return (cnt);
+	}
+	/* UTF-16 output. */
+	if (isz == 2 && ioff == (unparse == unicode_to_utf16be)) {
+		memcpy(p, s, cnt * 2);
+		return (cnt * 2);
+	}
+	for (i = 0; i < cnt; i++) {
+		if (unparse == unicode_to_utf16be) {
+			p[i * 2] = 0;
+			p[i * 2 + 1] = s[i * isz + ioff];
+		} else {
+			p[i * 2] = s[i * isz + ioff];
+			p[i * 2 + 1] = 0;
+		}
+	}
+	return (cnt * 2);
+}
+
 /*
  * Append new UTF-8 string to existing UTF-8 string.
  * Existing string is assumed to already be in proper form;
@@ -2745,7 +2826,13 @@ strncat_from_utf8_to_utf8(struct archive_string *as, const void *_src,
 
 		/* Skip UTF-8 sequences until we reach end-of-string or
 		 * a code point that needs conversion. */
-		while ((n = utf8_to_unicode(&uc, e, len)) > 0) {
+		for (;;) {
+			size_t run = ascii_run_len(e, len, 1, 0);
+
+			e += run;
+			len -= run;
+			if ((n = utf8_to_unicode(&uc, e, len)) <= 0)
+				break;
 			e += n;
 			len -= n;
 		}
@@ -2793,7 +2880,7 @@ archive_string_append_unicode(struct archive_string *as, const void *_p,
 	uint32_t uc;
 	size_t w;
 	size_t ts, tm;
-	int n, ret = 0;
+	int isz, ioff, n, ret = 0;
 	int (*parse)(uint32_t *, const char *, size_t);
 	size_t (*unparse)(char *, size_t, uint32_t);
 
@@ -2826,12 +2913,18 @@ archive_string_append_unicode(struct archive_string *as, const void *_p,
 	if (sc->flag & SCONV_FROM_UTF16BE) {
 		parse = utf16be_to_unicode;
 		tm = 1;
+		isz = 2;
+		ioff = 1;
 	} else if (sc->flag & SCONV_FROM_UTF16LE) {
 		parse = utf16le_to_unicode;
 		tm = 1;
+		isz = 2;
+		ioff = 0;
 	} else {
 		parse = cesu8_to_unicode;
 		tm = ts;
+		isz = 1;
+		ioff = 0;
 	}
 
 	if (archive_string_ensure(as, as->length + len * tm + ts) == NULL)
@@ -2840,7 +2933,24 @@ archive_string_append_unicode(struct archive_string *as, const void *_p,
 	s = (const char *)_p;
 	p = as->s + as->length;
 	endp = as->s + as->buffer_length - ts;
-	while ((n = parse(&uc, s, len)) != 0) {
+	for (;;) {
+		size_t run = ascii_run_len(s, len, isz, ioff);
+
+		if (run > 0) {
+			if ((size_t)(endp - p) < run * ts) {
+				as->length = p - as->s;
+				if (archive_string_ensure(as,
+				    as->buffer_length + len * tm + ts) == NULL)
+					return (-1);
+				p = as->s + as->length;
+				endp = as->s + as->buffer_length - ts;
+			}
+			p += ascii_run_copy(p, s, run, isz, ioff, unparse);
+			s += run * isz;
+			len -= run * isz;
+		}
+		if ((n = parse(&uc, s, len)) == 0)
+			break;
 		if (n < 0) {
 			/* Use a replaced unicode character. */
 			n *= -1;
@@ -3008,7 +3118,7 @@ archive_string_normalize_C(struct archive_string *as, const void *_p,
 	char *p, *endp;
 	uint32_t uc, uc2;
 	size_t w;
-	int always_replace, n, n2, ret = 0, spair, ts, tm;
+	int always_replace, n, n2, ret = 0, spair, ts, tm, isz, ioff;
 	int (*parse)(uint32_t *, const char *, size_t);
 	size_t (*unparse)(char *, size_t, uint32_t);
 
@@ -3049,14 +3159,20 @@ archive_string_normalize_C(struct archive_string *as, const void *_p,
 		parse = utf16be_to_unicode;
 		tm = 1;
 		spair = 4;/* surrogate pair size in UTF-16. */
+		isz = 2;
+		ioff = 1;
 	} else if (sc->flag & SCONV_FROM_UTF16LE) {
 		parse = utf16le_to_unicode;
 		tm = 1;
 		spair = 4;/* surrogate pair size in UTF-16. */
+		isz = 2;
+		ioff = 0;
 	} else {
 		parse = cesu8_to_unicode;
 		tm = ts;
 		spair = 6;/* surrogate pair size in UTF-8. */
+		isz = 1;
+		ioff = 0;
 	}
 
 	if (archive_string_ensure(as, as->length + len * tm + ts) == NULL)
@@ -3066,6 +3182,7 @@ archive_string_normalize_C(struct archive_string *as, const void *_p,
 	endp = as->s + as->buffer_length - ts;
 	while ((n = parse(&uc, s, len)) != 0) {
 		const char *ucptr, *uc2ptr;
+		size_t run;
 
 		if (n < 0) {
 			/* Use a replaced unicode character. */
@@ -3107,6 +3224,27 @@ archive_string_normalize_C(struct archive_string *as, const void *_p,
 			if (!IS_DECOMPOSABLE_BLOCK(uc2)) {
 				WRITE_UC();
 				REPLACE_UC_WITH_UC2();
+				if (uc < 0x80 &&
+				    (run = ascii_run_len(s, len, isz, ioff)) > 0) {
+					/*
+					 * A run of ASCII characters follows.
+					 * All but the last one cannot compose
+					 * with anything, so copy them in bulk
+					 * and carry on with the last one.
+					 */
+					WRITE_UC();
+					if ((size_t)(endp - p) < (run - 1) * ts)
+						EXPAND_BUFFER();
+					p += ascii_run_copy(p, s, run - 1,
+					    isz, ioff, unparse);
+					s += (run - 1) * isz;
+					len -= (run - 1) * isz;
+					uc = (unsigned char)s[ioff];
+					ucptr = always_replace ? NULL : s;
+					n = isz;
+					s += isz;
+					len -= isz;
+				}
 				continue;
 			}
 
@@ -3933,13 +4071,39 @@ archive_mstring_clean(struct archive_mstring *aes)
 	aes->aes_set = 0;
 }
 
+/*
+ * Forget the contents but keep the storage around for reuse.
+ */
+void
+archive_mstring_empty(struct archive_mstring *aes)
+{
+	archive_wstring_empty(&(aes->aes_wcs));
+	archive_string_empty(&(aes->aes_mbs));
+	archive_string_empty(&(aes->aes_utf8));
+	archive_string_empty(&(aes->aes_mbs_in_locale));
+	aes->aes_set = 0;
+}
+
 void
 archive_mstring_copy(struct archive_mstring *dest, struct archive_mstring *src)
 {
+	/*
+	 * Only copy the forms that are actually set; copying an unset
+	 * form would allocate a buffer just to hold an empty string.
+	 */
 	dest->aes_set = src->aes_set;
-	archive_string_copy(&(dest->aes_mbs), &(src->aes_mbs));
-	archive_string_copy(&(dest->aes_utf8), &(src->aes_utf8));
-	archive_wstring_copy(&(dest->aes_wcs), &(src->aes_wcs));
+	if (src->aes_set & AES_SET_MBS)
+		archive_string_copy(&(dest->aes_mbs), &(src->aes_mbs));
+	else
+		archive_string_empty(&(dest->aes_mbs));
+	if (src->aes_set & AES_SET_UTF8)
+		archive_string_copy(&(dest->aes_utf8), &(src->aes_utf8));
+	else
+		archive_string_empty(&(dest->aes_utf8));
+	if (src->aes_set & AES_SET_WCS)
+		archive_wstring_copy(&(dest->aes_wcs), &(src->aes_wcs));
+	else
+		archive_wstring_empty(&(dest->aes_wcs));
 }
 
 int
@@ -154,6 +154,32 @@ archive_read_next_header2(struct archive *a, struct archive_entry *entry)
 	return ((a->vtable->archive_read_next_header2)(a, entry));
 }
 
+int
+archive_read_next_headers(struct archive *a, struct archive_entry **entries,
+    size_t count, size_t *filled)
+{
+	size_t n = 0;
+	int r = ARCHIVE_OK;
+
+	while (n < count) {
+		r = (a->vtable->archive_read_next_header2)(a, entries[n]);
+		if (r == ARCHIVE_OK) {
+			n++;
+			continue;
+		}
+		/*
+		 * Stop after a warning so that the caller still gets
+		 * a chance to look at the error string for that entry.
+		 */
+		if (r == ARCHIVE_WARN)
+			n++;
+		break;
+	}
+	if (filled != NULL)
+		*filled = n;
+	return (r);
+}
+
 int
 archive_read_data_block(struct archive *a,
     const void **buff, size_t *s, la_int64_t *o)
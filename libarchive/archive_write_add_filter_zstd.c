@@ -49,6 +49,7 @@
 #endif
 
 #include "archive.h"
+#include "archive_endian.h"
 #include "archive_private.h"
 #include "archive_string.h"
 #include "archive_write_private.h"
@@ -73,6 +74,10 @@ struct zstd {
 	size_t		 cur_frame;
 	size_t		 cur_frame_in;
 	size_t		 cur_frame_out;
+	/* Seekable format: one 8-byte seek table entry per frame. */
+	int		 seekable;
+	uint32_t	 seek_table_frames;
+	struct archive_string seek_table;
 	ZSTD_CStream	*cstream;
 	ZSTD_outBuffer	 out;
 #else
@@ -89,6 +94,16 @@ struct zstd {
 
 #define LONG_STD 27
 
+/*
+ * Zstandard seekable format: a skippable frame at the end of the
+ * stream holds the compressed and decompressed size of every frame.
+ */
+#define SEEKABLE_MAGIC 0x8F92EAB1U
+#define SEEKABLE_SKIPPABLE_MAGIC 0x184D2A5EU
+#define SEEKABLE_FOOTER_SIZE 9
+#define SEEKABLE_DEFAULT_FRAME_SIZE (1024 * 1024)
+#define SEEKABLE_MAX_FRAME_SIZE 0x40000000U
+
 #define MINVER_NEGCLEVEL 10304
 #define MINVER_MINCLEVEL 10306
 #define MINVER_LONG 10302
@@ -104,6 +119,8 @@ static int archive_compressor_zstd_free(struct archive_write_filter *);
 #if HAVE_ZSTD_H && HAVE_ZSTD_compressStream
 static int drive_compressor(struct archive_write_filter *,
 		    struct zstd *, int, const void *, size_t);
+static int add_seek_table_entry(struct archive_write_filter *,
+		    struct zstd *);
 #endif
 static void free_data(struct zstd *);
 
@@ -299,6 +316,9 @@ archive_compressor_zstd_options(struct archive_write_filter *f, const char *key,
 	} else if (strcmp(key, "frame-per-file") == 0) {
 		zstd->frame_per_file = 1;
 		return (ARCHIVE_OK);
+	} else if (strcmp(key, "seekable") == 0) {
+		zstd->seekable = (value != NULL);
+		return (ARCHIVE_OK);
 	} else if (strcmp(key, "min-frame-in") == 0) {
 		if (string_to_size(value, &zstd->min_frame_in) != ARCHIVE_OK) {
 			archive_set_error(f->archive, ARCHIVE_ERRNO_MISC,
@@ -412,6 +432,15 @@ archive_compressor_zstd_open(struct archive_write_filter *f)
 
 	ZSTD_CCtx_setParameter(zstd->cstream, ZSTD_c_checksumFlag, 1);
 
+	/* Seeking is only useful if frames are reasonably small, and the
+	 * seek table cannot describe frames larger than 1 GiB. */
+	if (zstd->seekable) {
+		if (zstd->max_frame_in == SIZE_MAX)
+			zstd->max_frame_in = SEEKABLE_DEFAULT_FRAME_SIZE;
+		else if (zstd->max_frame_in > SEEKABLE_MAX_FRAME_SIZE)
+			zstd->max_frame_in = SEEKABLE_MAX_FRAME_SIZE;
+	}
+
 #if ZSTD_VERSION_NUMBER >= MINVER_LONG
 	ZSTD_CCtx_setParameter(zstd->cstream, ZSTD_c_windowLog, zstd->long_distance);
 #endif
@@ -455,10 +484,55 @@ static int
 archive_compressor_zstd_close(struct archive_write_filter *f)
 {
 	struct zstd *zstd = f->data;
+	unsigned char h[SEEKABLE_FOOTER_SIZE];
+	int ret;
 
 	if (zstd->state == running)
 		zstd->state = finishing;
-	return (drive_compressor(f, zstd, 1, NULL, 0));
+	ret = drive_compressor(f, zstd, 1, NULL, 0);
+	if (ret != ARCHIVE_OK || !zstd->seekable)
+		return (ret);
+
+	/* Append the seek table as a skippable frame. */
+	archive_le32enc(h, SEEKABLE_SKIPPABLE_MAGIC);
+	archive_le32enc(h + 4, (uint32_t)(archive_strlen(&zstd->seek_table)
+	    + SEEKABLE_FOOTER_SIZE));
+	ret = __archive_write_filter(f->next_filter, h, 8);
+	if (ret == ARCHIVE_OK && archive_strlen(&zstd->seek_table) > 0)
+		ret = __archive_write_filter(f->next_filter,
+		    zstd->seek_table.s, archive_strlen(&zstd->seek_table));
+	if (ret != ARCHIVE_OK)
+		return (ret);
+	archive_le32enc(h, zstd->seek_table_frames);
+	h[4] = 0; /* Seek_Table_Descriptor: no checksums. */
+	archive_le32enc(h + 5, SEEKABLE_MAGIC);
+	return (__archive_write_filter(f->next_filter, h, sizeof(h)));
+}
+
+/*
+ * Record a finished frame in the seek table.
+ */
+static int
+add_seek_table_entry(struct archive_write_filter *f, struct zstd *zstd)
+{
+	char e[8];
+
+	if (zstd->cur_frame_out > UINT32_MAX ||
+	    zstd->cur_frame_in > UINT32_MAX ||
+	    zstd->seek_table_frames == UINT32_MAX) {
+		archive_set_error(f->archive, ARCHIVE_ERRNO_MISC,
+		    "Zstd frame too large for seek table");
+		return (ARCHIVE_FATAL);
+	}
+	archive_le32enc(e, (uint32_t)zstd->cur_frame_out);
+	archive_le32enc(e + 4, (uint32_t)zstd->cur_frame_in);
+	if (archive_array_append(&zstd->seek_table, e, sizeof(e)) == NULL) {
+		archive_set_error(f->archive, ENOMEM,
+		    "Can't allocate data for seek table");
+		return (ARCHIVE_FATAL);
+	}
+	zstd->seek_table_frames++;
+	return (ARCHIVE_OK);
 }
 
 /*
@@ -493,6 +567,9 @@ drive_compressor(struct archive_write_filter *f,
 				zstd->state = resetting;
 			break;
 		case resetting:
+			if (zstd->seekable &&
+			    add_seek_table_entry(f, zstd) != ARCHIVE_OK)
+				goto fatal;
 			ZSTD_CCtx_reset(zstd->cstream, ZSTD_reset_session_only);
 			zstd->cur_frame++;
 			zstd->cur_frame_in = 0;
@@ -530,6 +607,7 @@ free_data(struct zstd *zstd)
 {
 	if (zstd != NULL) {
 		ZSTD_freeCStream(zstd->cstream);
+		archive_string_free(&zstd->seek_table);
 		free(zstd->out.dst);
 		free(zstd);
 	}
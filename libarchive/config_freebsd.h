@@ -160,6 +160,7 @@
 #define HAVE_PIPE 1
 #define HAVE_POLL 1
 #define HAVE_POLL_H 1
+#define HAVE_POSIX_FADVISE 1
 #define HAVE_POSIX_SPAWNP 1
 #define HAVE_PTHREAD_H 1
 #define HAVE_PWD_H 1
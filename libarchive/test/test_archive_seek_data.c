@@ -0,0 +1,344 @@
+/*-
+ * Copyright (c) 2026 libarchive contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR(S) ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test.h"
+
+/*
+ * archive_seek_data() on tar, cpio and stored zip entries.
+ */
+
+#define	DATA_SIZE	100000
+
+static unsigned char *
+make_data(void)
+{
+	unsigned char *p;
+	size_t i;
+
+	p = malloc(DATA_SIZE);
+	if (p != NULL)
+		for (i = 0; i < DATA_SIZE; i++)
+			p[i] = (unsigned char)(i * 13 + (i >> 8));
+	return (p);
+}
+
+static size_t
+write_archive(char *buff, size_t buffsize, const unsigned char *data,
+    int (*set_format)(struct archive *), int sparse, int store)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	size_t used;
+
+	assert((a = archive_write_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, set_format(a));
+	if (store)
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_write_set_format_option(a, "zip",
+		    "compression", "store"));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_add_filter_none(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_write_open_memory(a, buff, buffsize, &used));
+	assert((ae = archive_entry_new()) != NULL);
+	archive_entry_copy_pathname(ae, "file");
+	archive_entry_set_mode(ae, S_IFREG | 0644);
+	archive_entry_set_size(ae, DATA_SIZE);
+	if (sparse) {
+		archive_entry_sparse_add_entry(ae, 0, 10000);
+		archive_entry_sparse_add_entry(ae, 50000, 20000);
+		archive_entry_sparse_add_entry(ae, 90000, 10000);
+	}
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+	archive_entry_free(ae);
+	assertEqualInt(DATA_SIZE, archive_write_data(a, data, DATA_SIZE));
+	assert((ae = archive_entry_new()) != NULL);
+	archive_entry_copy_pathname(ae, "next");
+	archive_entry_set_mode(ae, S_IFREG | 0644);
+	archive_entry_set_size(ae, 4);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+	archive_entry_free(ae);
+	assertEqualInt(4, archive_write_data(a, "next", 4));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_close(a));
+	assertEqualInt(ARCHIVE_OK, archive_write_free(a));
+	return (used);
+}
+
+/* Read |len| bytes at |offset| and compare them with the expected data. */
+static void
+verify_range(struct archive *a, const unsigned char *expect, int64_t offset,
+    size_t len)
+{
+	unsigned char buff[4096];
+
+	assert(len <= sizeof(buff));
+	assertEqualInt(offset, archive_seek_data(a, offset, SEEK_SET));
+	assertEqualInt(len, archive_read_data(a, buff, len));
+	assertEqualMem(buff, expect + offset, len);
+}
+
+/* The next entry must still be readable after seeking around. */
+static void
+verify_next_entry(struct archive *a)
+{
+	struct archive_entry *ae;
+	char buff[8];
+
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString("next", archive_entry_pathname(ae));
+	assertEqualInt(4, archive_read_data(a, buff, sizeof(buff)));
+	assertEqualMem(buff, "next", 4);
+	assertEqualIntA(a, ARCHIVE_EOF, archive_read_next_header(a, &ae));
+}
+
+static void
+verify_seeks(struct archive *a, const unsigned char *expect)
+{
+	unsigned char buff[4096];
+	int64_t o;
+
+	/* Forward, then backward, then across the whole entry. */
+	verify_range(a, expect, 12345, 1000);
+	verify_range(a, expect, 99000, 1000);
+	verify_range(a, expect, 3, 4000);
+	verify_range(a, expect, 0, 4096);
+
+	/* Relative seeks. */
+	assertEqualInt(5096, archive_seek_data(a, 1000, SEEK_CUR));
+	assertEqualInt(100, archive_read_data(a, buff, 100));
+	assertEqualMem(buff, expect + 5096, 100);
+	assertEqualInt(DATA_SIZE - 10, archive_seek_data(a, -10, SEEK_END));
+	assertEqualInt(10, archive_read_data(a, buff, sizeof(buff)));
+	assertEqualMem(buff, expect + DATA_SIZE - 10, 10);
+
+	/* Past the end reports the offset but reads nothing. */
+	assertEqualInt(DATA_SIZE + 10,
+	    archive_seek_data(a, DATA_SIZE + 10, SEEK_SET));
+	assertEqualInt(0, archive_read_data(a, buff, sizeof(buff)));
+	assertEqualInt(ARCHIVE_FAILED, archive_seek_data(a, -1, SEEK_SET));
+
+	/* Reading the whole entry after all that still works. */
+	assertEqualInt(0, archive_seek_data(a, 0, SEEK_SET));
+	for (o = 0; o < DATA_SIZE; o += sizeof(buff)) {
+		size_t n = sizeof(buff);
+		if (o + n > DATA_SIZE)
+			n = (size_t)(DATA_SIZE - o);
+		assertEqualInt(n, archive_read_data(a, buff, sizeof(buff)));
+		if (memcmp(buff, expect + o, n) != 0) {
+			assertEqualMem(buff, expect + o, n);
+			break;
+		}
+	}
+	assertEqualInt(0, archive_read_data(a, buff, sizeof(buff)));
+}
+
+static void
+test_format(int (*set_format)(struct archive *),
+    int (*support_format)(struct archive *), int store)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	unsigned char *data;
+	char *buff;
+	size_t buffsize = 2 * DATA_SIZE, used;
+
+	assert((data = make_data()) != NULL);
+	assert((buff = malloc(buffsize)) != NULL);
+	if (data == NULL || buff == NULL) {
+		free(data);
+		free(buff);
+		return;
+	}
+	used = write_archive(buff, buffsize, data, set_format, 0, store);
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, support_format(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_open_memory(a, buff, used));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString("file", archive_entry_pathname(ae));
+	verify_seeks(a, data);
+	verify_next_entry(a);
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+
+	free(data);
+	free(buff);
+}
+
+DEFINE_TEST(test_archive_seek_data_tar)
+{
+	test_format(archive_write_set_format_pax,
+	    archive_read_support_format_tar, 0);
+}
+
+DEFINE_TEST(test_archive_seek_data_cpio)
+{
+	test_format(archive_write_set_format_cpio_newc,
+	    archive_read_support_format_cpio, 0);
+}
+
+DEFINE_TEST(test_archive_seek_data_zip)
+{
+	test_format(archive_write_set_format_zip,
+	    archive_read_support_format_zip, 1);
+}
+
+DEFINE_TEST(test_archive_seek_data_tar_sparse)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	unsigned char *data, *expect;
+	char *buff;
+	size_t buffsize = 2 * DATA_SIZE, used;
+
+	assert((data = make_data()) != NULL);
+	assert((expect = calloc(1, DATA_SIZE)) != NULL);
+	assert((buff = malloc(buffsize)) != NULL);
+	if (data == NULL || expect == NULL || buff == NULL) {
+		free(data);
+		free(expect);
+		free(buff);
+		return;
+	}
+	used = write_archive(buff, buffsize, data,
+	    archive_write_set_format_pax, 1, 0);
+	/* Holes read back as zeros. */
+	memcpy(expect, data, 10000);
+	memcpy(expect + 50000, data + 50000, 20000);
+	memcpy(expect + 90000, data + 90000, 10000);
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_tar(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_open_memory(a, buff, used));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualInt(3, archive_entry_sparse_count(ae));
+	verify_seeks(a, expect);
+	/* Ranges straddling the edges of a hole. */
+	verify_range(a, expect, 9000, 2000);
+	verify_range(a, expect, 49000, 2000);
+	verify_range(a, expect, 30000, 100);
+	verify_next_entry(a);
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+
+	free(data);
+	free(expect);
+	free(buff);
+}
+
+struct forward_only {
+	const char *buff;
+	size_t size;
+	int done;
+};
+
+static la_ssize_t
+forward_only_read(struct archive *a, void *client_data, const void **buff)
+{
+	struct forward_only *f = client_data;
+
+	(void)a; /* UNUSED */
+	if (f->done)
+		return (0);
+	f->done = 1;
+	*buff = f->buff;
+	return ((la_ssize_t)f->size);
+}
+
+/*
+ * Without a seek callback, forward seeks still work by skipping and
+ * backward seeks fail without disturbing the entry.
+ */
+DEFINE_TEST(test_archive_seek_data_tar_forward_only)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	struct forward_only f;
+	unsigned char *data;
+	unsigned char rbuff[1000];
+	char *buff;
+	size_t buffsize = 2 * DATA_SIZE;
+
+	assert((data = make_data()) != NULL);
+	assert((buff = malloc(buffsize)) != NULL);
+	if (data == NULL || buff == NULL) {
+		free(data);
+		free(buff);
+		return;
+	}
+	f.buff = buff;
+	f.size = write_archive(buff, buffsize, data,
+	    archive_write_set_format_pax, 0, 0);
+	f.done = 0;
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_tar(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_open(a, &f, NULL, forward_only_read, NULL));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	verify_range(a, data, 20000, sizeof(rbuff));
+	verify_range(a, data, 60000, sizeof(rbuff));
+	assertEqualInt(ARCHIVE_FAILED, archive_seek_data(a, 0, SEEK_SET));
+	assertEqualInt(sizeof(rbuff), archive_read_data(a, rbuff, sizeof(rbuff)));
+	assertEqualMem(rbuff, data + 61000, sizeof(rbuff));
+	verify_next_entry(a);
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+
+	free(data);
+	free(buff);
+}
+
+/* Compressed zip entries are not seekable. */
+DEFINE_TEST(test_archive_seek_data_zip_deflate)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	unsigned char *data;
+	unsigned char rbuff[100];
+	char *buff;
+	size_t buffsize = 2 * DATA_SIZE, used;
+
+#ifndef HAVE_ZLIB_H
+	skipping("Deflate compression is not supported");
+	return;
+#endif
+	assert((data = make_data()) != NULL);
+	assert((buff = malloc(buffsize)) != NULL);
+	if (data == NULL || buff == NULL) {
+		free(data);
+		free(buff);
+		return;
+	}
+	used = write_archive(buff, buffsize, data,
+	    archive_write_set_format_zip, 0, 0);
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_zip(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_open_memory(a, buff, used));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualInt(ARCHIVE_FAILED, archive_seek_data(a, 10, SEEK_SET));
+	assertEqualInt(sizeof(rbuff), archive_read_data(a, rbuff, sizeof(rbuff)));
+	assertEqualMem(rbuff, data, sizeof(rbuff));
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+
+	free(data);
+	free(buff);
+}
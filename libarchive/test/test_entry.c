@@ -711,6 +711,16 @@ DEFINE_TEST(test_entry)
 	assertEqualString(archive_entry_symlink(e2), "symlinkpath");
 	archive_entry_free(e2);
 
+	/* Verify that text set in any one form survives `clone` */
+	archive_entry_copy_pathname_w(e, L"wpath");
+	archive_entry_set_uname_utf8(e, "uuser");
+	e2 = archive_entry_clone(e);
+	assertEqualWString(archive_entry_pathname_w(e2), L"wpath");
+	assertEqualString(archive_entry_pathname(e2), "wpath");
+	assertEqualString(archive_entry_uname_utf8(e2), "uuser");
+	assertEqualString(archive_entry_uname(e2), "uuser");
+	archive_entry_free(e2);
+
 	/*
 	 * Test clear() implementation.
 	 */
@@ -745,6 +755,17 @@ DEFINE_TEST(test_entry)
 	assertEqualInt(archive_entry_acl_count(e, ARCHIVE_ENTRY_ACL_TYPE_DEFAULT), 0);
 	/* Extended attributes should be cleared. */
 	assertEqualInt(archive_entry_xattr_count(e), 0);
+	/* Other forms of the text fields should be cleared, too. */
+	assert(NULL == archive_entry_pathname_w(e));
+	assert(NULL == archive_entry_pathname_utf8(e));
+	assert(NULL == archive_entry_uname_w(e));
+	/* A cleared entry should be reusable. */
+	archive_entry_copy_pathname(e, "abc");
+	assertEqualString(archive_entry_pathname(e), "abc");
+	assertEqualWString(archive_entry_pathname_w(e), L"abc");
+	archive_entry_clear(e);
+	assertEqualString(archive_entry_pathname(e), NULL);
+	assert(NULL == archive_entry_pathname_w(e));
 
 	/*
 	 * Test archive_entry_copy_stat().
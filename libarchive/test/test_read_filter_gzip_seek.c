@@ -0,0 +1,218 @@
+/*-
+ * Copyright (c) 2026 libarchive contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR(S) ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test.h"
+
+/*
+ * Exercise random access to a .tar.gz through the gzip reader's
+ * checkpoint index.
+ */
+
+#define	NENTRIES	40
+#define	ENTRY_SIZE	(100 * 1024)
+
+static void
+fill(char *data, int i)
+{
+	uint32_t seed = 12345 + i;
+	size_t j;
+
+	/* Compressible, but not so much that deflate blocks get huge. */
+	for (j = 0; j < ENTRY_SIZE; j++) {
+		seed = seed * 1103515245 + 12345;
+		data[j] = "abcdefghijklmnop"[(seed >> 16) & 15];
+	}
+}
+
+/* Entry i holds the data generated from seed i + shift. */
+static void
+write_archive(char *buff, size_t buffsize, size_t *used, char *data,
+    int shift)
+{
+	struct archive_entry *ae;
+	struct archive *a;
+	char name[32];
+	int i;
+
+	assert((a = archive_write_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_set_format_pax(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_add_filter_gzip(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_write_open_memory(a, buff, buffsize, used));
+	for (i = 0; i < NENTRIES; i++) {
+		assert((ae = archive_entry_new()) != NULL);
+		snprintf(name, sizeof(name), "file%02d", i);
+		archive_entry_copy_pathname(ae, name);
+		archive_entry_set_mode(ae, AE_IFREG | 0644);
+		archive_entry_set_size(ae, ENTRY_SIZE);
+		assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+		archive_entry_free(ae);
+		fill(data, i + shift);
+		assertEqualInt(ENTRY_SIZE,
+		    archive_write_data(a, data, ENTRY_SIZE));
+	}
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_close(a));
+	assertEqualInt(ARCHIVE_OK, archive_write_free(a));
+}
+
+static void
+verify_entry(struct archive *a, int i, int shift, char *data, char *expect)
+{
+	struct archive_entry *ae;
+	char name[32];
+
+	snprintf(name, sizeof(name), "file%02d", i);
+	fill(expect, i + shift);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString(name, archive_entry_pathname(ae));
+	assertEqualInt(ENTRY_SIZE, archive_read_data(a, data, ENTRY_SIZE));
+	assertEqualMem(expect, data, ENTRY_SIZE);
+}
+
+static struct archive *
+open_archive(const char *buff, size_t used, const char *options)
+{
+	struct archive *a;
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_tar(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_filter_gzip(a));
+	if (options != NULL)
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_read_set_options(a, options));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    read_open_memory_seek(a, buff, used, 7777));
+	return (a);
+}
+
+DEFINE_TEST(test_read_filter_gzip_seek)
+{
+	struct archive_entry *ae;
+	struct archive *a;
+	la_int64_t offsets[NENTRIES];
+	char *buff, *data, *expect;
+	size_t buffsize = 8 * 1024 * 1024, used;
+	int i, r;
+
+	assert((a = archive_read_new()) != NULL);
+	r = archive_read_support_filter_gzip(a);
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+	if (r != ARCHIVE_OK) {
+		skipping("gzip reading not fully supported on this platform");
+		return;
+	}
+
+	assert((buff = malloc(buffsize)) != NULL);
+	assert((data = malloc(ENTRY_SIZE)) != NULL);
+	assert((expect = malloc(ENTRY_SIZE)) != NULL);
+
+	/* Create a .tar.gz. */
+	write_archive(buff, buffsize, &used, data, 0);
+
+	/* Without checkpoints the gzip stream cannot be repositioned. */
+	a = open_archive(buff, used, NULL);
+	verify_entry(a, 0, 0, data, expect);
+	assertEqualIntA(a, ARCHIVE_FAILED, archive_read_seek_header(a, 0));
+	verify_entry(a, 1, 0, data, expect);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/* Bad option values are rejected. */
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_filter_gzip(a));
+	assertEqualIntA(a, ARCHIVE_FAILED,
+	    archive_read_set_options(a, "gzip:checkpoint-interval=0"));
+	assertEqualIntA(a, ARCHIVE_FAILED,
+	    archive_read_set_options(a, "gzip:checkpoint-interval=12x"));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/* List once, building checkpoints and an index file. */
+	a = open_archive(buff, used,
+	    "gzip:checkpoint-interval=64k,gzip:index=test.gzidx");
+	for (i = 0; i < NENTRIES; i++) {
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_read_next_header(a, &ae));
+		offsets[i] = archive_read_header_position(a);
+	}
+	assertEqualIntA(a, ARCHIVE_EOF, archive_read_next_header(a, &ae));
+
+	/* Jump around. */
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[30]));
+	verify_entry(a, 30, 0, data, expect);
+	verify_entry(a, 31, 0, data, expect);
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[5]));
+	verify_entry(a, 5, 0, data, expect);
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[0]));
+	verify_entry(a, 0, 0, data, expect);
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[NENTRIES - 1]));
+	verify_entry(a, NENTRIES - 1, 0, data, expect);
+	assertEqualIntA(a, ARCHIVE_EOF, archive_read_next_header(a, &ae));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+	assertFileExists("test.gzidx");
+
+	/* A new reader can use the saved index right away. */
+	a = open_archive(buff, used, "gzip:index=test.gzidx");
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[25]));
+	verify_entry(a, 25, 0, data, expect);
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[12]));
+	verify_entry(a, 12, 0, data, expect);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/*
+	 * Rewriting the archive leaves the entries at the same offsets,
+	 * but the saved checkpoints no longer match its compressed data.
+	 * The stale index must be ignored and replaced.
+	 */
+	write_archive(buff, buffsize, &used, data, NENTRIES);
+	a = open_archive(buff, used, "gzip:index=test.gzidx");
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[25]));
+	verify_entry(a, 25, NENTRIES, data, expect);
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[12]));
+	verify_entry(a, 12, NENTRIES, data, expect);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+	a = open_archive(buff, used, "gzip:index=test.gzidx");
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[20]));
+	verify_entry(a, 20, NENTRIES, data, expect);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/* A damaged index is ignored. */
+	assertMakeFile("test.gzidx", 0644, "not an index");
+	a = open_archive(buff, used, "gzip:index=test.gzidx");
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[33]));
+	verify_entry(a, 33, NENTRIES, data, expect);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	free(expect);
+	free(data);
+	free(buff);
+}
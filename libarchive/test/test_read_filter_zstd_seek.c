@@ -0,0 +1,225 @@
+/*-
+ * Copyright (c) 2026 libarchive contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR(S) ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test.h"
+
+/*
+ * The zstd reader's handling of the seek table at the end of a stream
+ * written in the Zstandard seekable format.  Random access through the
+ * tar reader itself is covered by test_read_seek_header.
+ */
+
+static char buff[256 * 1024];
+static const char *names[] = { "a", "b", "c" };
+
+static size_t
+write_archive(const char *options)
+{
+	struct archive_entry *ae;
+	struct archive *a;
+	char data[64 * 1024];
+	size_t used;
+	int i;
+
+	assert((a = archive_write_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_set_format_ustar(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_add_filter_zstd(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_set_options(a, options));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_write_open_memory(a, buff, sizeof(buff), &used));
+	assert((ae = archive_entry_new()) != NULL);
+	archive_entry_set_mode(ae, AE_IFREG | 0644);
+	archive_entry_set_size(ae, sizeof(data));
+	for (i = 0; i < 3; i++) {
+		archive_entry_copy_pathname(ae, names[i]);
+		assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+		memset(data, 'a' + i, sizeof(data));
+		assertEqualInt(sizeof(data),
+		    archive_write_data(a, data, sizeof(data)));
+	}
+	archive_entry_free(ae);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_close(a));
+	assertEqualInt(ARCHIVE_OK, archive_write_free(a));
+	return (used);
+}
+
+static struct archive *
+open_archive(size_t used, const char *options)
+{
+	struct archive *a;
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_tar(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_filter_zstd(a));
+	if (options != NULL)
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_read_set_options(a, options));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    read_open_memory_seek(a, buff, used, 7777));
+	return (a);
+}
+
+/* Read the next entry and check its name and the last byte of data. */
+static void
+verify_entry(struct archive *a, const char *name)
+{
+	struct archive_entry *ae;
+	char data[64 * 1024];
+
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString(name, archive_entry_pathname(ae));
+	assertEqualInt(sizeof(data), archive_read_data(a, data, sizeof(data)));
+	assertEqualInt(name[0], data[sizeof(data) - 1]);
+}
+
+/*
+ * An input that can reach its end but then cannot get back to the
+ * start, so the seek table probe leaves it stranded.
+ */
+struct stuck_data {
+	size_t		 used;
+	size_t		 pos;
+};
+
+static la_ssize_t
+stuck_read(struct archive *a, void *client_data, const void **p)
+{
+	struct stuck_data *d = client_data;
+	size_t n = d->used - d->pos;
+
+	(void)a; /* UNUSED */
+	if (n > 7777)
+		n = 7777;
+	*p = buff + d->pos;
+	d->pos += n;
+	return ((la_ssize_t)n);
+}
+
+static la_int64_t
+stuck_seek(struct archive *a, void *client_data, la_int64_t offset,
+    int whence)
+{
+	struct stuck_data *d = client_data;
+
+	(void)a; /* UNUSED */
+	if (whence == SEEK_END)
+		offset += d->used;
+	else if (whence == SEEK_CUR)
+		offset += d->pos;
+	if (offset <= 0 || offset > (la_int64_t)d->used)
+		return (ARCHIVE_FATAL);
+	d->pos = (size_t)offset;
+	return (offset);
+}
+
+DEFINE_TEST(test_read_filter_zstd_seek)
+{
+	struct stuck_data stuck;
+	struct archive_entry *ae;
+	struct archive *a;
+	la_int64_t offsets[3];
+	size_t used;
+	int i, r;
+
+	assert((a = archive_write_new()) != NULL);
+	r = archive_write_add_filter_zstd(a);
+	assertEqualInt(ARCHIVE_OK, archive_write_free(a));
+	if (r != ARCHIVE_OK) {
+		skipping("zstd writing not supported on this platform");
+		return;
+	}
+	assert((a = archive_read_new()) != NULL);
+	r = archive_read_support_filter_zstd(a);
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+	if (r != ARCHIVE_OK) {
+		skipping("zstd reading not supported on this platform");
+		return;
+	}
+
+	/* Asking for a seek table that a plain stream lacks is harmless. */
+	used = write_archive("zstd:compression-level=1");
+	a = open_archive(used, "zstd:seekable");
+	verify_entry(a, "a");
+	assertEqualIntA(a, ARCHIVE_FAILED, archive_read_seek_header(a, 0));
+	verify_entry(a, "b");
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/* The seekable format ends with the seek table footer. */
+	used = write_archive("zstd:seekable,zstd:max-frame-size=16k");
+	assertEqualInt(0x8F92EAB1, i4le(buff + used - 4));
+	assertEqualInt(0, buff[used - 5]);
+
+	/* The table is only looked for when the option is set. */
+	a = open_archive(used, NULL);
+	verify_entry(a, "a");
+	assertEqualIntA(a, ARCHIVE_FAILED, archive_read_seek_header(a, 0));
+	verify_entry(a, "b");
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/* Without a seek callback the option is ignored. */
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_tar(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_filter_zstd(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_set_options(a, "zstd:seekable"));
+	assertEqualIntA(a, ARCHIVE_OK, read_open_memory(a, buff, used, 7777));
+	verify_entry(a, "a");
+	assertEqualIntA(a, ARCHIVE_FAILED, archive_read_seek_header(a, 0));
+	verify_entry(a, "b");
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/* Failing to return from the seek table is an error. */
+	stuck.used = used;
+	stuck.pos = 0;
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_tar(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_filter_zstd(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_set_options(a, "zstd:seekable"));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_set_callback_data(a, &stuck));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_set_read_callback(a, stuck_read));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_set_seek_callback(a, stuck_seek));
+	assertEqualIntA(a, ARCHIVE_FATAL, archive_read_open1(a));
+	assertEqualString("Can't seek back to the start of zstd data",
+	    archive_error_string(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/* With the table loaded, entries can be revisited in any order. */
+	a = open_archive(used, "zstd:seekable");
+	for (i = 0; i < 3; i++) {
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_read_next_header(a, &ae));
+		offsets[i] = archive_read_header_position(a);
+	}
+	assertEqualIntA(a, ARCHIVE_EOF, archive_read_next_header(a, &ae));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_seek_header(a, offsets[1]));
+	verify_entry(a, "b");
+	verify_entry(a, "c");
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_seek_header(a, offsets[0]));
+	verify_entry(a, "a");
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+}
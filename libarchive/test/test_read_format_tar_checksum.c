@@ -0,0 +1,114 @@
+/*-
+ * Copyright (c) 2026 libarchive contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR(S) ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test.h"
+
+/*
+ * The tar reader accepts header checksums computed over either
+ * unsigned bytes (as POSIX requires) or signed bytes (as some old
+ * BSD, Solaris and HP-UX tars did), and rejects anything else.
+ */
+
+static size_t
+make_ustar(char *buff, size_t buffsize)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	size_t used;
+
+	assert((a = archive_write_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_set_format_ustar(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_add_filter_none(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_write_open_memory(a, buff, buffsize, &used));
+	assert((ae = archive_entry_new()) != NULL);
+	/* High-bit bytes make the signed and unsigned sums differ. */
+	archive_entry_copy_pathname(ae, "caf\xe9\xe9\xe9");
+	archive_entry_set_mode(ae, S_IFREG | 0644);
+	archive_entry_set_size(ae, 0);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+	archive_entry_free(ae);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_close(a));
+	assertEqualInt(ARCHIVE_OK, archive_write_free(a));
+	return (used);
+}
+
+static void
+set_checksum(char *h, int sum)
+{
+	snprintf(h + 148, 8, "%06o", sum & 0777777);
+	h[155] = ' ';
+}
+
+static int
+read_first_header(const char *buff, size_t used)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	int r;
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_tar(a));
+	/* A bad checksum already fails the format bid. */
+	r = archive_read_open_memory(a, buff, used);
+	if (r == ARCHIVE_OK)
+		r = archive_read_next_header(a, &ae);
+	if (r == ARCHIVE_OK)
+		assertEqualInt(6, strlen(archive_entry_pathname(ae)));
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+	return (r);
+}
+
+DEFINE_TEST(test_read_format_tar_checksum)
+{
+	char buff[4096];
+	size_t used, i;
+	int usum, ssum;
+
+	used = make_ustar(buff, sizeof(buff));
+	assertEqualInt(ARCHIVE_OK, read_first_header(buff, used));
+
+	usum = ssum = 8 * ' ';
+	for (i = 0; i < 512; i++) {
+		if (i >= 148 && i < 156)
+			continue;
+		usum += (unsigned char)buff[i];
+		ssum += (signed char)buff[i];
+	}
+	assert(usum != ssum);
+
+	/* Signed-byte checksum from an old tar. */
+	set_checksum(buff, ssum);
+	assertEqualInt(ARCHIVE_OK, read_first_header(buff, used));
+
+	/* Neither sum matches. */
+	set_checksum(buff, usum + 1);
+	assertEqualInt(ARCHIVE_FATAL, read_first_header(buff, used));
+	set_checksum(buff, ssum - 256);
+	assertEqualInt(ARCHIVE_FATAL, read_first_header(buff, used));
+
+	/* Back to the correct unsigned checksum. */
+	set_checksum(buff, usum);
+	assertEqualInt(ARCHIVE_OK, read_first_header(buff, used));
+}
@@ -0,0 +1,288 @@
+/*-
+ * Copyright (c) 2026 libarchive contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR(S) ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test.h"
+
+#include <locale.h>
+
+/*
+ * With the "central-directory" option the seekable zip reader builds
+ * entries from the central directory and reads local file headers
+ * only when entry data is requested.
+ */
+
+#define	NFILES	8
+
+static size_t
+make_zip(char *buff, size_t buffsize)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	char name[32], data[4096];
+	size_t used;
+	int i;
+
+	assert((a = archive_write_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_set_format_zip(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_add_filter_none(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_write_open_memory(a, buff, buffsize, &used));
+
+	assert((ae = archive_entry_new()) != NULL);
+	archive_entry_copy_pathname(ae, "dir/");
+	archive_entry_set_mode(ae, AE_IFDIR | 0755);
+	archive_entry_set_mtime(ae, 1000000, 0);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+	archive_entry_free(ae);
+
+	for (i = 0; i < NFILES; i++) {
+		snprintf(name, sizeof(name), "dir/file%d", i);
+		memset(data, '0' + i, sizeof(data));
+		/* Alternate stored and compressed entries. */
+		assertEqualIntA(a, ARCHIVE_OK, i % 2 ?
+		    archive_write_zip_set_compression_store(a) :
+		    archive_write_zip_set_compression_deflate(a));
+		assert((ae = archive_entry_new()) != NULL);
+		archive_entry_copy_pathname(ae, name);
+		archive_entry_set_mode(ae, AE_IFREG | 0644);
+		archive_entry_set_mtime(ae, 1000000 + i, 0);
+		archive_entry_set_size(ae, 1000 + i);
+		assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+		archive_entry_free(ae);
+		assertEqualInt(1000 + i, archive_write_data(a, data, 1000 + i));
+	}
+
+	assert((ae = archive_entry_new()) != NULL);
+	archive_entry_copy_pathname(ae, "link");
+	archive_entry_set_mode(ae, AE_IFLNK | 0777);
+	archive_entry_copy_symlink(ae, "dir/file0");
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+	archive_entry_free(ae);
+
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_close(a));
+	assertEqualInt(ARCHIVE_OK, archive_write_free(a));
+	return (used);
+}
+
+DEFINE_TEST(test_read_format_zip_central_directory)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	char *buff;
+	char name[32], data[2048];
+	size_t buffsize = 64 * 1024, used;
+	int i;
+
+#ifndef HAVE_ZLIB_H
+	skipping("Deflate compression is not supported");
+	return;
+#endif
+	assert((buff = malloc(buffsize)) != NULL);
+	if (buff == NULL)
+		return;
+	used = make_zip(buff, buffsize);
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_support_format_zip_seekable(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_set_format_option(a, "zip", "central-directory", "1"));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_open_memory(a, buff, used));
+
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString("dir/", archive_entry_pathname(ae));
+	assertEqualInt(AE_IFDIR, archive_entry_filetype(ae));
+	assertEqualInt(1000000, archive_entry_mtime(ae));
+
+	for (i = 0; i < NFILES; i++) {
+		snprintf(name, sizeof(name), "dir/file%d", i);
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_read_next_header(a, &ae));
+		assertEqualString(name, archive_entry_pathname(ae));
+		assertEqualInt(AE_IFREG, archive_entry_filetype(ae));
+		assertEqualInt(1000 + i, archive_entry_size(ae));
+		assertEqualInt(1000000 + i, archive_entry_mtime(ae));
+		/* Read every third entry; the rest are skipped
+		 * without touching their local headers. */
+		if (i % 3 != 0)
+			continue;
+		if (i % 2) {
+			/* Stored entries can seek once the local
+			 * header has been read on demand. */
+			assertEqualInt(500, archive_seek_data(a, 500, SEEK_SET));
+			assertEqualInt(500 + i,
+			    archive_read_data(a, data, sizeof(data)));
+		} else
+			assertEqualInt(1000 + i,
+			    archive_read_data(a, data, sizeof(data)));
+		assertEqualInt('0' + i, data[0]);
+		assertEqualInt('0' + i, data[499 + i]);
+	}
+
+	/* Symlink targets are stored as data, so these still use the
+	 * local header. */
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString("link", archive_entry_pathname(ae));
+	assertEqualInt(AE_IFLNK, archive_entry_filetype(ae));
+	assertEqualString("dir/file0", archive_entry_symlink(ae));
+
+	assertEqualIntA(a, ARCHIVE_EOF, archive_read_next_header(a, &ae));
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+	free(buff);
+}
+
+/*
+ * Without Mac extensions the central directory is read one record at
+ * a time, so entries before a damaged record are still returned.
+ */
+DEFINE_TEST(test_read_format_zip_central_directory_incremental)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	char *buff, *p, *last;
+	char data[2048];
+	size_t buffsize = 64 * 1024, used;
+	int i;
+
+#ifndef HAVE_ZLIB_H
+	skipping("Deflate compression is not supported");
+	return;
+#endif
+	assert((buff = malloc(buffsize)) != NULL);
+	if (buff == NULL)
+		return;
+	used = make_zip(buff, buffsize);
+
+	/* Damage the signature of the last central directory record. */
+	last = NULL;
+	for (p = buff; p + 4 <= buff + used; p++)
+		if (memcmp(p, "PK\001\002", 4) == 0)
+			last = p;
+	assert(last != NULL);
+	if (last == NULL) {
+		free(buff);
+		return;
+	}
+	last[3] = 'X';
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_support_format_zip_seekable(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_set_format_option(a, "zip", "central-directory", "1"));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_set_format_option(a, "zip", "mac-ext", NULL));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_open_memory(a, buff, used));
+
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString("dir/", archive_entry_pathname(ae));
+	for (i = 0; i < NFILES; i++) {
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_read_next_header(a, &ae));
+		assertEqualInt(1000 + i, archive_entry_size(ae));
+		/* Going back to the directory after reading data
+		 * resumes at the right record. */
+		if (i == 2)
+			assertEqualInt(1000 + i,
+			    archive_read_data(a, data, sizeof(data)));
+	}
+	/* The symlink's record was damaged. */
+	assertEqualIntA(a, ARCHIVE_FATAL, archive_read_next_header(a, &ae));
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+
+	/* Loading the whole directory up front fails at once. */
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_support_format_zip_seekable(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_open_memory(a, buff, used));
+	assertEqualIntA(a, ARCHIVE_FATAL, archive_read_next_header(a, &ae));
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+	free(buff);
+}
+
+/*
+ * Entries with an Info-ZIP Unicode Path extra field must get the same
+ * names whether or not the "central-directory" option is set.  In this
+ * archive the directory's copies of that field disagree with the
+ * local headers' ones.
+ */
+static void
+list_names(const char *refname, const char *options, char names[][64],
+    int count)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	const char *p;
+	int i;
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_support_format_zip_seekable(a));
+	if (options != NULL)
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_read_set_options(a, options));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_open_filename(a, refname, 10240));
+	for (i = 0; i < count; i++) {
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_read_next_header(a, &ae));
+		assert((p = archive_entry_pathname_utf8(ae)) != NULL);
+		if (p != NULL)
+			strncpy(names[i], p, 63);
+	}
+	assertEqualIntA(a, ARCHIVE_EOF, archive_read_next_header(a, &ae));
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+}
+
+DEFINE_TEST(test_read_format_zip_central_directory_utf8_paths)
+{
+	const char *refname = "test_read_format_zip_7075_utf8_paths.zip";
+	char local[4][64], central[4][64], slurped[4][64];
+	int i;
+
+	extract_reference_file(refname);
+	if (NULL == setlocale(LC_ALL, "en_US.UTF-8")) {
+		skipping("en_US.UTF-8 locale not available on this system.");
+		return;
+	}
+
+	memset(local, 0, sizeof(local));
+	memset(central, 0, sizeof(central));
+	memset(slurped, 0, sizeof(slurped));
+	list_names(refname, NULL, local, 4);
+	/* Directory records read one at a time ... */
+	list_names(refname, "zip:central-directory", central, 4);
+	/* ... and all at once. */
+	list_names(refname, "zip:central-directory,zip:mac-ext", slurped, 4);
+	for (i = 0; i < 4; i++) {
+		assertEqualUTF8String(local[i], central[i]);
+		assertEqualUTF8String(local[i], slurped[i]);
+	}
+#if !defined(__APPLE__)
+	assertEqualUTF8String("File 2 - \xC3\xB6.txt", central[1]);
+	assertEqualUTF8String("File 3 - \xC3\xA4.txt", central[2]);
+#endif
+	/* The local header's Unicode path fails its CRC check. */
+	assertEqualUTF8String("File 4 - xx.txt", central[3]);
+}
@@ -0,0 +1,153 @@
+/*-
+ * Copyright (c) 2026 libarchive contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR(S) ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test.h"
+
+/*
+ * Deflated entries whose recorded sizes are wrong, or whose data is
+ * damaged, must be reported the same way whichever inflate backend
+ * the reader uses.  With libdeflate, an understated size exercises
+ * the fallback to zlib and an overstated one the short result.
+ */
+
+#define	BODY_SIZE	65536
+
+static char buff[BODY_SIZE + 4096];
+static char body[BODY_SIZE];
+
+/* Write a one-entry zip and return the offset of its central
+ * directory record. */
+static size_t
+make_zip(size_t *used)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	size_t i;
+
+	for (i = 0; i < sizeof(body); i++)
+		body[i] = "abcdefgh"[(i * 7 + i / 13) % 8];
+	assert((a = archive_write_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_set_format_zip(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_write_zip_set_compression_deflate(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_write_open_memory(a, buff, sizeof(buff), used));
+	assert((ae = archive_entry_new()) != NULL);
+	archive_entry_copy_pathname(ae, "file");
+	archive_entry_set_mode(ae, AE_IFREG | 0644);
+	archive_entry_set_size(ae, sizeof(body));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+	archive_entry_free(ae);
+	assertEqualInt(sizeof(body), archive_write_data(a, body, sizeof(body)));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_close(a));
+	assertEqualInt(ARCHIVE_OK, archive_write_free(a));
+
+	for (i = 0; i + 46 <= *used; i++) {
+		if (memcmp(buff + i, "PK\001\002", 4) == 0)
+			return (i);
+	}
+	failure("No central directory record");
+	assert(0);
+	return (0);
+}
+
+/* Patch the uncompressed size in the central directory record. */
+static void
+set_uncompressed_size(size_t cd, unsigned int size)
+{
+	buff[cd + 24] = (char)(size & 0xff);
+	buff[cd + 25] = (char)((size >> 8) & 0xff);
+	buff[cd + 26] = (char)((size >> 16) & 0xff);
+	buff[cd + 27] = (char)((size >> 24) & 0xff);
+}
+
+/*
+ * Read the entry with the seekable reader, which trusts the sizes in
+ * the central directory.  Returns the result that ended the data.
+ */
+static int
+read_entry(size_t used, char *out, size_t outsize, size_t *got,
+    char *error, size_t errorsize)
+{
+	struct archive *a;
+	struct archive_entry *ae;
+	ssize_t r;
+
+	*got = 0;
+	error[0] = '\0';
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_support_format_zip_seekable(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    read_open_memory_seek(a, buff, used, 7777));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	while ((r = archive_read_data(a, out + *got, outsize - *got)) > 0)
+		*got += r;
+	if (r != ARCHIVE_OK && archive_error_string(a) != NULL)
+		snprintf(error, errorsize, "%s", archive_error_string(a));
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+	return ((int)r);
+}
+
+DEFINE_TEST(test_read_format_zip_deflate_size)
+{
+	char out[2 * BODY_SIZE], error[256];
+	size_t cd, local_data, used, got;
+
+	if (archive_zlib_version() == NULL) {
+		skipping("Zip deflate test requires zlib");
+		return;
+	}
+	cd = make_zip(&used);
+
+	/* As written. */
+	assertEqualInt(ARCHIVE_OK,
+	    read_entry(used, out, sizeof(out), &got, error, sizeof(error)));
+	assertEqualInt(BODY_SIZE, got);
+	assertEqualMem(body, out, BODY_SIZE);
+
+	/* An understated size is caught once inflating overruns it;
+	 * libdeflate runs out of room and hands the entry to zlib. */
+	set_uncompressed_size(cd, 1000);
+	assertEqualInt(ARCHIVE_FAILED,
+	    read_entry(used, out, sizeof(out), &got, error, sizeof(error)));
+	assertEqualString("ZIP uncompressed data is larger than the declared "
+	    "entry size (read at least 65536, expected 1000)", error);
+
+	/* An overstated size is caught at the end of the data. */
+	set_uncompressed_size(cd, BODY_SIZE + 1000);
+	assertEqualInt(ARCHIVE_FAILED,
+	    read_entry(used, out, sizeof(out), &got, error, sizeof(error)));
+	assertEqualString("ZIP uncompressed data is wrong size "
+	    "(read 65536, expected 66536)", error);
+
+	/* Damaged data is fatal: make the first block's type the
+	 * reserved one. */
+	set_uncompressed_size(cd, BODY_SIZE);
+	local_data = 30 + i2le(buff + 26) + i2le(buff + 28);
+	buff[local_data] |= 0x06;
+	assertEqualInt(ARCHIVE_FATAL,
+	    read_entry(used, out, sizeof(out), &got, error, sizeof(error)));
+	assertEqualInt(0, got);
+}
@@ -61,6 +61,12 @@ DEFINE_TEST(test_read_format_zip_high_compression)
         assertEqualIntA(a, ARCHIVE_OK, read_open_memory_seek(a, p, archive_size, 16 * 1024));
 	assertEqualInt(ARCHIVE_OK, archive_read_next_header(a, &entry));
 
+#if HAVE_LIBDEFLATE_H && HAVE_LIBDEFLATE
+	/* libdeflate inflates the whole entry at once. */
+	assertEqualInt(ARCHIVE_OK, archive_read_data_block(a, &pv, &s, &o));
+	assertEqualInt(262304, s);
+	assertEqualInt(0, o);
+#else
 	assertEqualInt(ARCHIVE_OK, archive_read_data_block(a, &pv, &s, &o));
 	assertEqualInt(262144, s);
 	assertEqualInt(0, o);
@@ -68,6 +74,7 @@ DEFINE_TEST(test_read_format_zip_high_compression)
 	assertEqualInt(ARCHIVE_OK, archive_read_data_block(a, &pv, &s, &o));
 	assertEqualInt(160, s);
 	assertEqualInt(262144, o);
+#endif
 
 	assertEqualInt(ARCHIVE_EOF, archive_read_data_block(a, &pv, &s, &o));
 
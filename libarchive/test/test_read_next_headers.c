@@ -0,0 +1,109 @@
+/*-
+ * Copyright (c) 2026 libarchive contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR(S) ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test.h"
+
+/*
+ * Read the headers of an archive in batches with
+ * archive_read_next_headers(), reusing the same entry objects
+ * for every batch.
+ */
+
+#define	NENTRIES	10
+#define	BATCH		4
+
+DEFINE_TEST(test_read_next_headers)
+{
+	static char buff[64 * 1024];
+	static char data[2000];
+	struct archive *a;
+	struct archive_entry *ae, *entries[BATCH];
+	char name[32];
+	size_t used, filled;
+	int i, n, r;
+
+	/* Build a tar archive with some data in every entry. */
+	memset(data, 'a', sizeof(data));
+	assert((a = archive_write_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_set_format_pax_restricted(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_write_open_memory(a, buff, sizeof(buff), &used));
+	for (i = 0; i < NENTRIES; i++) {
+		assert((ae = archive_entry_new()) != NULL);
+		snprintf(name, sizeof(name), "file%d", i);
+		archive_entry_copy_pathname(ae, name);
+		archive_entry_set_mode(ae, AE_IFREG | 0644);
+		archive_entry_set_size(ae, 1000 + i);
+		assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+		archive_entry_free(ae);
+		assertEqualIntA(a, 1000 + i, archive_write_data(a, data, 1000 + i));
+	}
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_close(a));
+	assertEqualInt(ARCHIVE_OK, archive_write_free(a));
+
+	for (i = 0; i < BATCH; i++)
+		assert((entries[i] = archive_entry_new()) != NULL);
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_all(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_filter_all(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_open_memory(a, buff, used));
+
+	/* Two full batches. */
+	n = 0;
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_next_headers(a, entries, BATCH, &filled));
+	assertEqualInt(BATCH, filled);
+	for (i = 0; i < (int)filled; i++, n++) {
+		snprintf(name, sizeof(name), "file%d", n);
+		assertEqualString(name, archive_entry_pathname(entries[i]));
+		assertEqualInt(1000 + n, archive_entry_size(entries[i]));
+	}
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_next_headers(a, entries, BATCH, &filled));
+	assertEqualInt(BATCH, filled);
+	for (i = 0; i < (int)filled; i++, n++) {
+		snprintf(name, sizeof(name), "file%d", n);
+		assertEqualString(name, archive_entry_pathname(entries[i]));
+		assertEqualInt(1000 + n, archive_entry_size(entries[i]));
+	}
+
+	/* The last batch is short and reports the end of the archive. */
+	r = archive_read_next_headers(a, entries, BATCH, &filled);
+	assertEqualIntA(a, ARCHIVE_EOF, r);
+	assertEqualInt(NENTRIES - 2 * BATCH, filled);
+	for (i = 0; i < (int)filled; i++, n++) {
+		snprintf(name, sizeof(name), "file%d", n);
+		assertEqualString(name, archive_entry_pathname(entries[i]));
+		assertEqualInt(1000 + n, archive_entry_size(entries[i]));
+	}
+	assertEqualInt(NENTRIES, n);
+	assertEqualInt(NENTRIES, archive_file_count(a));
+
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_close(a));
+	assertEqualInt(ARCHIVE_OK, archive_read_free(a));
+
+	for (i = 0; i < BATCH; i++)
+		archive_entry_free(entries[i]);
+}
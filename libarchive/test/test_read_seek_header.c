@@ -0,0 +1,189 @@
+/*-
+ * Copyright (c) 2026 libarchive contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR(S) ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR(S) BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test.h"
+
+#define	NENTRIES	6
+
+static char buff[64 * 1024];
+
+static void
+entry_name(char *name, size_t len, int i)
+{
+	/* Every other name is long enough to need a pax extension. */
+	if (i & 1)
+		snprintf(name, len, "dir%0120d/file%d", 0, i);
+	else
+		snprintf(name, len, "file%d", i);
+}
+
+static void
+verify_entry(struct archive *a, int i)
+{
+	struct archive_entry *ae;
+	char name[160], data[2048], expect[2048];
+
+	entry_name(name, sizeof(name), i);
+	memset(expect, 'a' + i, sizeof(expect));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString(name, archive_entry_pathname(ae));
+	assertEqualInt(100 * i + 7, archive_entry_size(ae));
+	assertEqualInt(100 * i + 7, archive_read_data(a, data, sizeof(data)));
+	assertEqualMem(expect, data, 100 * i + 7);
+}
+
+DEFINE_TEST(test_read_seek_header)
+{
+	struct archive_entry *ae;
+	struct archive *a;
+	char name[160], data[2048];
+	la_int64_t offsets[NENTRIES];
+	size_t used;
+	int i;
+
+	/* Create an archive. */
+	assert((a = archive_write_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_set_format_pax(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_add_filter_none(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_write_open_memory(a, buff, sizeof(buff), &used));
+	for (i = 0; i < NENTRIES; i++) {
+		assert((ae = archive_entry_new()) != NULL);
+		entry_name(name, sizeof(name), i);
+		archive_entry_copy_pathname(ae, name);
+		archive_entry_set_mode(ae, AE_IFREG | 0644);
+		archive_entry_set_size(ae, 100 * i + 7);
+		assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+		archive_entry_free(ae);
+		memset(data, 'a' + i, sizeof(data));
+		assertEqualInt(100 * i + 7,
+		    archive_write_data(a, data, 100 * i + 7));
+	}
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_close(a));
+	assertEqualInt(ARCHIVE_OK, archive_write_free(a));
+
+	/* List it once, recording where each header starts. */
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_tar(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    read_open_memory_seek(a, buff, used, 512));
+	for (i = 0; i < NENTRIES; i++) {
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_read_next_header(a, &ae));
+		offsets[i] = archive_read_header_position(a);
+		assertEqualInt(0, offsets[i] % 512);
+	}
+	assertEqualIntA(a, ARCHIVE_EOF, archive_read_next_header(a, &ae));
+
+	/* Jump back from EOF to an entry in the middle. */
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_seek_header(a, offsets[3]));
+	verify_entry(a, 3);
+	verify_entry(a, 4);
+
+	/* Jump backwards with data of the current entry still unread. */
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_seek_header(a, offsets[1]));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_seek_header(a, offsets[0]));
+	verify_entry(a, 0);
+
+	/* Jump forwards. */
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_read_seek_header(a, offsets[NENTRIES - 1]));
+	verify_entry(a, NENTRIES - 1);
+	assertEqualIntA(a, ARCHIVE_EOF, archive_read_next_header(a, &ae));
+
+	/* Offsets that cannot be header starts are rejected. */
+	assertEqualIntA(a, ARCHIVE_FAILED,
+	    archive_read_seek_header(a, offsets[2] + 1));
+	assertEqualIntA(a, ARCHIVE_FAILED, archive_read_seek_header(a, -512));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_seek_header(a, offsets[2]));
+	verify_entry(a, 2);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/* Without a seek callback the request fails but reading continues. */
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_tar(a));
+	assertEqualIntA(a, ARCHIVE_OK, read_open_memory(a, buff, used, 512));
+	verify_entry(a, 0);
+	assertEqualIntA(a, ARCHIVE_FAILED,
+	    archive_read_seek_header(a, offsets[3]));
+	verify_entry(a, 1);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/* Formats without support report that. */
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_raw(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_filter_all(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    read_open_memory_seek(a, buff, used, 512));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualIntA(a, ARCHIVE_FAILED, archive_read_seek_header(a, 0));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+
+	/*
+	 * GNU long name and long link headers precede the entry they
+	 * describe, so seeking to a recorded position must pick them up.
+	 */
+	assert((a = archive_write_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_set_format_gnutar(a));
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_add_filter_none(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    archive_write_open_memory(a, buff, sizeof(buff), &used));
+	entry_name(name, sizeof(name), 1);
+	assert((ae = archive_entry_new()) != NULL);
+	archive_entry_copy_pathname(ae, "short");
+	archive_entry_set_mode(ae, AE_IFREG | 0644);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+	archive_entry_copy_pathname(ae, name);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+	archive_entry_copy_pathname(ae, "link");
+	archive_entry_copy_hardlink(ae, name);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_header(a, ae));
+	archive_entry_free(ae);
+	assertEqualIntA(a, ARCHIVE_OK, archive_write_close(a));
+	assertEqualInt(ARCHIVE_OK, archive_write_free(a));
+
+	assert((a = archive_read_new()) != NULL);
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_support_format_tar(a));
+	assertEqualIntA(a, ARCHIVE_OK,
+	    read_open_memory_seek(a, buff, used, 512));
+	for (i = 0; i < 3; i++) {
+		assertEqualIntA(a, ARCHIVE_OK,
+		    archive_read_next_header(a, &ae));
+		offsets[i] = archive_read_header_position(a);
+	}
+	assertEqualIntA(a, ARCHIVE_EOF, archive_read_next_header(a, &ae));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_seek_header(a, offsets[2]));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString("link", archive_entry_pathname(ae));
+	assertEqualString(name, archive_entry_hardlink(ae));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_seek_header(a, offsets[1]));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString(name, archive_entry_pathname(ae));
+	assertEqualString(NULL, archive_entry_hardlink(ae));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_seek_header(a, offsets[0]));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_next_header(a, &ae));
+	assertEqualString("short", archive_entry_pathname(ae));
+	assertEqualIntA(a, ARCHIVE_OK, archive_read_free(a));
+}
@@ -167,6 +167,10 @@ read_archive(struct bsdtar *bsdtar, char mode, struct archive *writer)
 	if (cset_read_support_filter_program(bsdtar->cset, a) == 0)
 		archive_read_support_filter_all(a);
 	archive_read_support_format_all(a);
+	/* A plain listing needs nothing from Zip local file headers. */
+	if (mode == 't' && bsdtar->verbose < 2)
+		archive_read_set_format_option(a, "zip",
+		    "central-directory", "1");
 
 	reader_options = getenv(ENV_READER_OPTIONS);
 	if (reader_options != NULL) {
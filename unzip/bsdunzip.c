@@ -1034,6 +1034,11 @@ unzip(const char *fn)
 	if (O_arg)
 		ac(archive_read_set_format_option(a, "zip", "hdrcharset", O_arg));
 
+	/* Listing needs nothing from the local file headers. */
+	if (zipinfo_mode || (v_opt && !t_opt))
+		ac(archive_read_set_format_option(a, "zip",
+		    "central-directory", "1"));
+
 	if (P_arg)
 		archive_read_add_passphrase(a, P_arg);
 	else